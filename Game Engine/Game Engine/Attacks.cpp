@@ -0,0 +1,134 @@
+#include "Attacks.h"
+
+namespace attacks {
+    Magic rookMagics[64];
+    Magic bishopMagics[64];
+    Bitboard betweenTable[64][64];
+    Bitboard lineTable[64][64];
+
+    namespace {
+        Bitboard rookTable[0x19000];  // Sum of 2^popcount(mask) over all squares
+        Bitboard bishopTable[0x1480];
+        bool initialized = false;
+
+        // xorshift64* generator, sparse numbers make good magic candidates
+        class MagicRng {
+            uint64_t s;
+        public:
+            MagicRng(uint64_t seed) : s(seed) {}
+
+            uint64_t rand() {
+                s ^= s >> 12;
+                s ^= s << 25;
+                s ^= s >> 27;
+                return s * 2685821657736338717ULL;
+            }
+
+            uint64_t sparseRand() {
+                return rand() & rand() & rand();
+            }
+        };
+
+        void initMagics(PieceType pt, Bitboard table[], Magic magics[]) {
+            // Seeds picked so the search converges quickly on every rank
+            const uint64_t seeds[8] = { 728, 10316, 55013, 32803, 12281, 15100, 16645, 255 };
+
+            static Bitboard occupancy[4096];
+            static Bitboard reference[4096];
+            static int epoch[4096];
+            int attempt = 0;
+            int size = 0;
+
+            for (int sq = 0; sq < 64; sq++) {
+                // Board edges are not part of the relevant occupancy unless the slider sits on them
+                Bitboard rankEdges = (RANK_1_BB | RANK_8_BB) & ~(RANK_1_BB << (8 * rankOf(sq)));
+                Bitboard fileEdges = (FILE_A_BB | FILE_H_BB) & ~(FILE_A_BB << fileOf(sq));
+
+                Magic& m = magics[sq];
+                m.mask = slidingAttacks(pt, sq, 0) & ~(rankEdges | fileEdges);
+                m.shift = 64 - popcount(m.mask);
+                m.attacks = sq == A1 ? table : magics[sq - 1].attacks + size;
+
+                // Carry-Rippler walk over every subset of the mask
+                Bitboard b = 0;
+                size = 0;
+                do {
+                    occupancy[size] = b;
+                    reference[size] = slidingAttacks(pt, sq, b);
+#if defined(USE_PEXT)
+                    m.attacks[m.index(b)] = reference[size];
+#endif
+                    size++;
+                    b = (b - m.mask) & m.mask;
+                } while (b);
+
+#if !defined(USE_PEXT)
+                MagicRng rng(seeds[rankOf(sq)]);
+                for (int i = 0; i < size;) {
+                    for (m.magic = 0; popcount((m.magic * m.mask) >> 56) < 6;) {
+                        m.magic = rng.sparseRand();
+                    }
+
+                    // A candidate is good if every occupancy maps to the right attacks,
+                    // the epoch counter saves clearing the table between attempts
+                    for (attempt++, i = 0; i < size; i++) {
+                        unsigned idx = m.index(occupancy[i]);
+                        if (epoch[idx] < attempt) {
+                            epoch[idx] = attempt;
+                            m.attacks[idx] = reference[i];
+                        }
+                        else if (m.attacks[idx] != reference[i]) {
+                            break;
+                        }
+                    }
+                }
+#endif
+            }
+        }
+    }
+
+    Bitboard slidingAttacks(PieceType pt, int sq, Bitboard occupied) {
+        const int rookDirections[4][2] = { {0, 1}, {0, -1}, {1, 0}, {-1, 0} };
+        const int bishopDirections[4][2] = { {1, 1}, {1, -1}, {-1, 1}, {-1, -1} };
+        const int (*directions)[2] = pt == ROOK ? rookDirections : bishopDirections;
+
+        Bitboard result = 0;
+        for (int d = 0; d < 4; d++) {
+            int file = fileOf(sq);
+            int rank = rankOf(sq);
+            while (true) {
+                file += directions[d][0];
+                rank += directions[d][1];
+                if (file < 0 || file >= 8 || rank < 0 || rank >= 8)
+                    break;
+
+                Bitboard b = squareBB(makeSquare(file, rank));
+                result |= b;
+                if (occupied & b)
+                    break;
+            }
+        }
+        return result;
+    }
+
+    void init() {
+        if (initialized) {
+            return;
+        }
+        initMagics(ROOK, rookTable, rookMagics);
+        initMagics(BISHOP, bishopTable, bishopMagics);
+
+        for (int a = 0; a < 64; a++) {
+            for (PieceType pt : { BISHOP, ROOK }) {
+                Bitboard fromA = slidingAttacks(pt, a, 0);
+                for (int b = 0; b < 64; b++) {
+                    if (fromA & squareBB(b)) {
+                        lineTable[a][b] = (fromA & slidingAttacks(pt, b, 0)) | squareBB(a) | squareBB(b);
+                        betweenTable[a][b] = slidingAttacks(pt, a, squareBB(b)) & slidingAttacks(pt, b, squareBB(a));
+                    }
+                }
+            }
+        }
+        initialized = true;
+    }
+}
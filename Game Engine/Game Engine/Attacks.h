@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include "Bitboard.h"
+
+#if defined(USE_PEXT)
+#include <immintrin.h>
+#endif
+
+// ======================
+// Precomputed attack tables
+// ======================
+// Leaper tables (knight, king, pawn) are built at compile time. Slider tables use
+// fancy magic bitboards (or PEXT when built with USE_PEXT) filled in by attacks::init().
+
+namespace attacks {
+
+    // Compile time leaper tables
+
+    constexpr Bitboard leaperTarget(int sq, int df, int dr) {
+        int file = fileOf(sq) + df;
+        int rank = rankOf(sq) + dr;
+        return (file >= 0 && file < 8 && rank >= 0 && rank < 8) ? squareBB(makeSquare(file, rank)) : 0;
+    }
+
+    constexpr std::array<Bitboard, 64> makeKnightTable() {
+        constexpr int offsets[8][2] = { {1, 2}, {2, 1}, {-1, 2}, {-2, 1}, {-1, -2}, {-2, -1}, {1, -2}, {2, -1} };
+        std::array<Bitboard, 64> table{};
+        for (int sq = 0; sq < 64; sq++) {
+            for (const auto& offset : offsets) {
+                table[sq] |= leaperTarget(sq, offset[0], offset[1]);
+            }
+        }
+        return table;
+    }
+
+    constexpr std::array<Bitboard, 64> makeKingTable() {
+        constexpr int offsets[8][2] = { {0, 1}, {1, 0}, {0, -1}, {-1, 0}, {1, 1}, {-1, 1}, {-1, -1}, {1, -1} };
+        std::array<Bitboard, 64> table{};
+        for (int sq = 0; sq < 64; sq++) {
+            for (const auto& offset : offsets) {
+                table[sq] |= leaperTarget(sq, offset[0], offset[1]);
+            }
+        }
+        return table;
+    }
+
+    constexpr std::array<std::array<Bitboard, 64>, COLOR_NB> makePawnTable() {
+        std::array<std::array<Bitboard, 64>, COLOR_NB> table{};
+        for (int sq = 0; sq < 64; sq++) {
+            table[WHITE][sq] = leaperTarget(sq, -1, 1) | leaperTarget(sq, 1, 1);
+            table[BLACK][sq] = leaperTarget(sq, -1, -1) | leaperTarget(sq, 1, -1);
+        }
+        return table;
+    }
+
+    inline constexpr std::array<Bitboard, 64> KNIGHT_ATTACKS = makeKnightTable();
+    inline constexpr std::array<Bitboard, 64> KING_ATTACKS = makeKingTable();
+    inline constexpr std::array<std::array<Bitboard, 64>, COLOR_NB> PAWN_ATTACKS = makePawnTable();
+
+    // Slider tables
+
+    struct Magic {
+        Bitboard mask;
+        Bitboard magic;
+        Bitboard* attacks;
+        unsigned shift;
+
+        unsigned index(Bitboard occupied) const {
+#if defined(USE_PEXT)
+            return unsigned(_pext_u64(occupied, mask));
+#else
+            return unsigned(((occupied & mask) * magic) >> shift);
+#endif
+        }
+    };
+
+    extern Magic rookMagics[64];
+    extern Magic bishopMagics[64];
+
+    // Squares strictly between two aligned squares, and the full line through them
+    extern Bitboard betweenTable[64][64];
+    extern Bitboard lineTable[64][64];
+
+    // Fills the slider tables, safe to call more than once
+    void init();
+
+    // Slow ray walk, used to build the tables
+    Bitboard slidingAttacks(PieceType pt, int sq, Bitboard occupied);
+
+    // Lookups
+
+    inline Bitboard knightAttacks(int sq) {
+        return KNIGHT_ATTACKS[sq];
+    }
+
+    inline Bitboard kingAttacks(int sq) {
+        return KING_ATTACKS[sq];
+    }
+
+    inline Bitboard pawnAttacks(Color c, int sq) {
+        return PAWN_ATTACKS[c][sq];
+    }
+
+    inline Bitboard bishopAttacks(int sq, Bitboard occupied) {
+        const Magic& m = bishopMagics[sq];
+        return m.attacks[m.index(occupied)];
+    }
+
+    inline Bitboard rookAttacks(int sq, Bitboard occupied) {
+        const Magic& m = rookMagics[sq];
+        return m.attacks[m.index(occupied)];
+    }
+
+    inline Bitboard queenAttacks(int sq, Bitboard occupied) {
+        return bishopAttacks(sq, occupied) | rookAttacks(sq, occupied);
+    }
+
+    inline Bitboard between(int a, int b) {
+        return betweenTable[a][b];
+    }
+
+    inline Bitboard line(int a, int b) {
+        return lineTable[a][b];
+    }
+}
@@ -0,0 +1,425 @@
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Attacks.h"
+#include "Search.h"
+#include "Evaluation.h"
+#include "MoveGen.h"
+#include "Nnue.h"
+#include "OpeningBook.h"
+#include "Pgn.h"
+
+// Headless engine benchmarks
+//   bench smp [--depth N] [--hash MB] [--threads 1,2,4,8,16]
+//       time-to-depth of the Lazy SMP search on a fixed position set, per thread count, with
+//       the pawn cache hit rate and the share of beta cutoffs made by the first move searched
+//   bench eval [--iterations N]
+//       static evaluations per second over the same position set
+//   bench nnue [--net FILE] [--nodes N] [--iterations N]
+//       network against classical evaluation: make, evaluate and unmake rate, then nodes per
+//       second of a search limited to N nodes per position. Without a network file a random
+//       one is written and timed.
+//   bench pgn FILE [--no-replay]
+//       games and moves per second streamed from a PGN file, every move resolved and played
+//   bench book FILE [--lines N]
+//       Polyglot book probe latency, on the positions of N random book lines from the start
+//       position and on the same positions one move out of book
+
+namespace {
+    // Fixed middlegame and endgame set, varied enough that the speedup is not one position's luck
+    const std::vector<std::string> BENCH_FENS = {
+        START_FEN,
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+        "2r3k1/pp3ppp/2n1b3/3p4/3P4/2PB1N2/P4PPP/R5K1 w - - 0 20",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "6k1/5ppp/8/3P4/8/8/5PPP/6K1 w - - 0 1",
+    };
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::vector<int> parseList(const std::string& list) {
+        std::vector<int> values;
+        std::stringstream ss(list);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            values.push_back(std::stoi(item));
+        }
+        return values;
+    }
+
+    int benchSmp(int argc, char* argv[]) {
+        int depth = 12;
+        int hashMb = 64;
+        std::vector<int> threadCounts = { 1, 2, 4, 8, 16 };
+        for (int i = 0; i < argc; i++) {
+            if (!strcmp(argv[i], "--depth") && i + 1 < argc) {
+                depth = std::stoi(argv[++i]);
+            }
+            else if (!strcmp(argv[i], "--hash") && i + 1 < argc) {
+                hashMb = std::stoi(argv[++i]);
+            }
+            else if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+                threadCounts = parseList(argv[++i]);
+            }
+        }
+
+        TranspositionTable tt(hashMb);
+        double baseline = 0;
+        std::cout << "Lazy SMP time to depth " << depth << " over " << BENCH_FENS.size() << " positions, hash " << hashMb << " MB" << std::endl;
+        for (int threads : threadCounts) {
+            Search search(tt, threads);
+            SearchLimits limits;
+            limits.depth = depth;
+
+            uint64_t nodes = 0;
+            double elapsed = 0;
+            double pawnHitRate = 0;
+            double firstMoveCutoffs = 0;
+            for (const std::string& fen : BENCH_FENS) {
+                Position position;
+                position.setFen(fen);
+                tt.clear();
+                search.clearHistory();
+
+                auto start = std::chrono::steady_clock::now();
+                search.think(position, limits);
+                elapsed += secondsSince(start);
+                nodes += search.getNodes();
+                pawnHitRate += search.getPawnHitRate() / BENCH_FENS.size();
+                firstMoveCutoffs += search.getFirstMoveCutoffRate() / BENCH_FENS.size();
+            }
+
+            if (baseline == 0) {
+                baseline = elapsed;
+            }
+            std::cout << "threads " << std::setw(3) << threads
+                << "  time " << std::fixed << std::setprecision(3) << std::setw(8) << elapsed << "s"
+                << "  nodes " << std::setw(12) << nodes
+                << "  nps " << std::setw(11) << uint64_t(nodes / elapsed)
+                << "  speedup " << std::setprecision(2) << baseline / elapsed << "x"
+                << "  pawn hits " << std::setprecision(1) << 100 * pawnHitRate << "%"
+                << "  first move cutoffs " << 100 * firstMoveCutoffs << "%" << std::endl;
+        }
+        return 0;
+    }
+
+    int benchEval(int argc, char* argv[]) {
+        int iterations = 1000000;
+        for (int i = 0; i < argc; i++) {
+            if (!strcmp(argv[i], "--iterations") && i + 1 < argc) {
+                iterations = std::stoi(argv[++i]);
+            }
+        }
+
+        std::vector<Position> positions(BENCH_FENS.size());
+        for (size_t i = 0; i < BENCH_FENS.size(); i++) {
+            positions[i].setFen(BENCH_FENS[i]);
+        }
+
+        // Once from scratch and once through the pawn cache, the checksums must agree.
+        // The checksum also keeps the calls from being optimized away.
+        PawnTable pawns;
+        for (PawnTable* table : { (PawnTable*)nullptr, &pawns }) {
+            int64_t checksum = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; i++) {
+                checksum += eval::evaluate(positions[i % positions.size()], table);
+            }
+            double elapsed = secondsSince(start);
+
+            std::cout << (table ? "pawn cache " : "no cache   ") << "evaluations " << iterations
+                << "  time " << std::fixed << std::setprecision(3) << elapsed << "s"
+                << "  evals/s " << uint64_t(iterations / elapsed)
+                << "  ns/eval " << std::setprecision(1) << 1e9 * elapsed / iterations
+                << "  checksum " << checksum;
+            if (table) {
+                std::cout << "  hits " << 100.0 * table->getHits() / table->getProbes() << "%";
+            }
+            std::cout << std::endl;
+        }
+        return 0;
+    }
+
+    // Network of small random weights in the file format, only good for timing
+    bool writeRandomNetwork(const std::string& path) {
+        uint64_t s = 0x9E3779B97F4A7C15ULL;
+        auto next = [&s](int range) {
+            s ^= s >> 12;
+            s ^= s << 25;
+            s ^= s >> 27;
+            return int(((s * 2685821657736338717ULL) >> 33) % uint64_t(2 * range + 1)) - range;
+        };
+
+        const uint32_t header[8] = { NNUE_MAGIC, NNUE_VERSION, NNUE_INPUTS, NNUE_HALF, NNUE_HIDDEN, NNUE_HIDDEN, 0, 0 };
+        std::vector<int16_t> ftBiases(NNUE_HALF);
+        std::vector<int16_t> ftWeights(size_t(NNUE_INPUTS) * NNUE_HALF);
+        std::vector<int32_t> l1Biases(NNUE_HIDDEN);
+        std::vector<int8_t> l1Weights(NNUE_HIDDEN * 2 * NNUE_HALF);
+        std::vector<int32_t> l2Biases(NNUE_HIDDEN);
+        std::vector<int8_t> l2Weights(NNUE_HIDDEN * NNUE_HIDDEN);
+        int32_t outBias = 0;
+        std::vector<int8_t> outWeights(NNUE_HIDDEN);
+        for (auto& w : ftBiases) w = int16_t(32 + next(32));
+        for (auto& w : ftWeights) w = int16_t(next(24));
+        for (auto& w : l1Biases) w = next(512);
+        for (auto& w : l1Weights) w = int8_t(next(16));
+        for (auto& w : l2Biases) w = next(512);
+        for (auto& w : l2Weights) w = int8_t(next(32));
+        for (auto& w : outWeights) w = int8_t(next(64));
+
+        std::ofstream out(path, std::ios::binary);
+        auto write = [&out](const void* data, size_t size) {
+            out.write(static_cast<const char*>(data), std::streamsize(size));
+        };
+        write(header, sizeof(header));
+        write(ftBiases.data(), ftBiases.size() * sizeof(int16_t));
+        write(ftWeights.data(), ftWeights.size() * sizeof(int16_t));
+        write(l1Biases.data(), l1Biases.size() * sizeof(int32_t));
+        write(l1Weights.data(), l1Weights.size());
+        write(l2Biases.data(), l2Biases.size() * sizeof(int32_t));
+        write(l2Weights.data(), l2Weights.size());
+        write(&outBias, sizeof(outBias));
+        write(outWeights.data(), outWeights.size());
+        return bool(out);
+    }
+
+    int benchNnue(int argc, char* argv[]) {
+        std::string path;
+        uint64_t nodeLimit = 1000000;
+        int iterations = 20;
+        for (int i = 0; i < argc; i++) {
+            if (!strcmp(argv[i], "--net") && i + 1 < argc) {
+                path = argv[++i];
+            }
+            else if (!strcmp(argv[i], "--nodes") && i + 1 < argc) {
+                nodeLimit = std::stoull(argv[++i]);
+            }
+            else if (!strcmp(argv[i], "--iterations") && i + 1 < argc) {
+                iterations = std::stoi(argv[++i]);
+            }
+        }
+
+        if (path.empty()) {
+            path = "random.nnue";
+            if (!writeRandomNetwork(path)) {
+                std::cerr << "Unable to write " << path << std::endl;
+                return 1;
+            }
+            std::cout << "No --net given, timing random weights written to " << path << std::endl;
+        }
+        if (!nnue::load(path)) {
+            std::cerr << "Unable to load network " << path << std::endl;
+            return 1;
+        }
+        std::cout << "network " << path << ", " << nnue::getSimdName() << " kernels" << std::endl;
+
+        for (bool useNetwork : { false, true }) {
+            nnue::setEnabled(useNetwork);
+            const char* name = useNetwork ? "nnue     " : "classical";
+
+            // Every legal move of every position, so the accumulator updates are paid for
+            // the way the search pays for them
+            PawnTable pawns;
+            int64_t checksum = 0;
+            uint64_t evaluations = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; i++) {
+                for (const std::string& fen : BENCH_FENS) {
+                    Position position;
+                    position.setFen(fen);
+                    MoveList moves;
+                    generateMoves(position, moves);
+                    for (int m = 0; m < moves.size(); m++) {
+                        position.makeMove(moves[m]);
+                        checksum += eval::evaluate(position, &pawns);
+                        position.unmakeMove();
+                    }
+                    evaluations += moves.size();
+                }
+            }
+            double elapsed = secondsSince(start);
+            std::cout << name << "  make/eval/unmake " << std::setw(10) << uint64_t(evaluations / elapsed) << "/s"
+                << "  ns " << std::fixed << std::setprecision(1) << 1e9 * elapsed / evaluations
+                << "  checksum " << checksum << std::endl;
+        }
+
+        // The two evaluations grow different trees, a node budget keeps the runs comparable
+        for (bool useNetwork : { false, true }) {
+            nnue::setEnabled(useNetwork);
+            const char* name = useNetwork ? "nnue     " : "classical";
+
+            TranspositionTable tt(64);
+            Search search(tt, 1);
+            SearchLimits limits;
+            limits.nodes = nodeLimit;
+            uint64_t nodes = 0;
+            double elapsed = 0;
+            for (const std::string& fen : BENCH_FENS) {
+                Position position;
+                position.setFen(fen);
+                tt.clear();
+                search.clearHistory();
+
+                auto start = std::chrono::steady_clock::now();
+                search.think(position, limits);
+                elapsed += secondsSince(start);
+                nodes += search.getNodes();
+            }
+            std::cout << name << "  search"
+                << "  time " << std::fixed << std::setprecision(3) << std::setw(8) << elapsed << "s"
+                << "  nodes " << std::setw(10) << nodes
+                << "  nps " << std::setw(9) << uint64_t(nodes / elapsed) << std::endl;
+        }
+        return 0;
+    }
+
+    int benchPgn(int argc, char* argv[]) {
+        if (argc < 1) {
+            std::cerr << "bench pgn needs a file" << std::endl;
+            return 1;
+        }
+        bool replay = true;
+        for (int i = 1; i < argc; i++) {
+            if (!strcmp(argv[i], "--no-replay")) {
+                replay = false;
+            }
+        }
+
+        PgnReader reader;
+        if (!reader.open(argv[0])) {
+            std::cerr << "Unable to open " << argv[0] << std::endl;
+            return 1;
+        }
+
+        PgnGame game;
+        Position position;
+        uint64_t moves = 0;
+        uint64_t failed = 0;
+        auto start = std::chrono::steady_clock::now();
+        while (reader.next(game)) {
+            moves += game.moves.size();
+            if (replay && !pgn::replay(game, position)) {
+                failed++;
+            }
+        }
+        double elapsed = secondsSince(start);
+
+        std::cout << (replay ? "read and replayed " : "read ") << reader.getGamesRead() << " games, " << moves << " moves"
+            << "  time " << std::fixed << std::setprecision(3) << elapsed << "s"
+            << "  games/s " << uint64_t(reader.getGamesRead() / elapsed)
+            << "  moves/s " << uint64_t(moves / elapsed);
+        if (replay) {
+            std::cout << "  unresolved " << failed;
+        }
+        std::cout << std::endl;
+        return failed ? 1 : 0;
+    }
+
+    int benchBook(int argc, char* argv[]) {
+        if (argc < 1) {
+            std::cerr << "bench book needs a file" << std::endl;
+            return 1;
+        }
+        int lines = 1000;
+        for (int i = 1; i < argc; i++) {
+            if (!strcmp(argv[i], "--lines") && i + 1 < argc) {
+                lines = std::stoi(argv[++i]);
+            }
+        }
+
+        OpeningBook book;
+        if (!book.open(argv[0])) {
+            std::cerr << "Unable to open " << argv[0] << std::endl;
+            return 1;
+        }
+
+        // Book positions, and for each of them a position reached by a move the book does not
+        // give, which is most likely missing from it
+        std::mt19937_64 random(1);
+        std::vector<std::string> hits, misses;
+        Position position;
+        for (int line = 0; line < lines; line++) {
+            position.setFen(START_FEN);
+            while (true) {
+                Move move = book.pick(position, random());
+                if (move.isNull()) {
+                    break;
+                }
+                hits.push_back(position.getFen());
+
+                MoveList moves;
+                generateMoves(position, moves);
+                position.makeMove(moves[int(random() % moves.size())]);
+                misses.push_back(position.getFen());
+                position.unmakeMove();
+                position.makeMove(move);
+            }
+        }
+        if (hits.empty()) {
+            std::cerr << "The start position is not in the book" << std::endl;
+            return 1;
+        }
+
+        std::cout << book.getEntryCount() << " entries, " << hits.size() << " positions on " << lines << " lines" << std::endl;
+        for (const auto& set : { std::make_pair("book", &hits), std::make_pair("out of book", &misses) }) {
+            // Positions are far too big to keep thousands around, each is set up untimed
+            uint64_t found = 0;
+            double elapsed = 0;
+            for (const std::string& fen : *set.second) {
+                position.setFen(fen);
+                auto start = std::chrono::steady_clock::now();
+                found += !book.pick(position, random()).isNull();
+                elapsed += secondsSince(start);
+            }
+            std::cout << std::setw(12) << set.first << "  probes " << set.second->size() << "  found " << found
+                << "  us/probe " << std::fixed << std::setprecision(3) << elapsed * 1e6 / set.second->size() << std::endl;
+        }
+        return 0;
+    }
+
+    void printUsage() {
+        std::cout << "Usage: bench smp [--depth N] [--hash MB] [--threads 1,2,4,8,16]" << std::endl;
+        std::cout << "       bench eval [--iterations N]" << std::endl;
+        std::cout << "       bench nnue [--net FILE] [--nodes N] [--iterations N]" << std::endl;
+        std::cout << "       bench pgn FILE [--no-replay]" << std::endl;
+        std::cout << "       bench book FILE [--lines N]" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+
+    attacks::init();
+    std::string mode = argv[1];
+    if (mode == "smp") {
+        return benchSmp(argc - 2, argv + 2);
+    }
+    if (mode == "eval") {
+        return benchEval(argc - 2, argv + 2);
+    }
+    if (mode == "nnue") {
+        return benchNnue(argc - 2, argv + 2);
+    }
+    if (mode == "pgn") {
+        return benchPgn(argc - 2, argv + 2);
+    }
+    if (mode == "book") {
+        return benchBook(argc - 2, argv + 2);
+    }
+    printUsage();
+    return 1;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <bit>
+
+// ======================
+// Basic types for the headless chess core (no SDL in here)
+// ======================
+
+typedef uint64_t Bitboard;
+typedef uint8_t PieceCode;
+
+enum Color : int { WHITE, BLACK, COLOR_NB };
+enum PieceType : int { PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING, PIECE_TYPE_NB };
+
+// Squares are numbered a1 = 0 ... h8 = 63, file major inside each rank
+enum Square : int {
+    A1, B1, C1, D1, E1, F1, G1, H1,
+    A2, B2, C2, D2, E2, F2, G2, H2,
+    A3, B3, C3, D3, E3, F3, G3, H3,
+    A4, B4, C4, D4, E4, F4, G4, H4,
+    A5, B5, C5, D5, E5, F5, G5, H5,
+    A6, B6, C6, D6, E6, F6, G6, H6,
+    A7, B7, C7, D7, E7, F7, G7, H7,
+    A8, B8, C8, D8, E8, F8, G8, H8,
+    NO_SQUARE
+};
+
+enum CastlingRight : int {
+    WHITE_OO = 1,
+    WHITE_OOO = 2,
+    BLACK_OO = 4,
+    BLACK_OOO = 8,
+    ALL_CASTLING = 15
+};
+
+constexpr PieceCode NO_PIECE = 12;
+
+constexpr Bitboard FILE_A_BB = 0x0101010101010101ULL;
+constexpr Bitboard FILE_H_BB = FILE_A_BB << 7;
+constexpr Bitboard RANK_1_BB = 0xFFULL;
+constexpr Bitboard RANK_8_BB = RANK_1_BB << 56;
+
+// Piece codes
+
+constexpr PieceCode makePiece(Color c, PieceType pt) {
+    return PieceCode(int(c) * PIECE_TYPE_NB + int(pt));
+}
+
+constexpr Color colorOf(PieceCode pc) {
+    return Color(pc / PIECE_TYPE_NB);
+}
+
+constexpr PieceType typeOf(PieceCode pc) {
+    return PieceType(pc % PIECE_TYPE_NB);
+}
+
+// Squares and coordinates
+
+constexpr int fileOf(int sq) {
+    return sq & 7;
+}
+
+constexpr int rankOf(int sq) {
+    return sq >> 3;
+}
+
+constexpr int makeSquare(int file, int rank) {
+    return rank * 8 + file;
+}
+
+// The UI addresses cells as (x, y) with y = 0 being the top row (black's back rank)
+constexpr int squareFromCords(int x, int y) {
+    return makeSquare(x, 7 - y);
+}
+
+constexpr int cordsX(int sq) {
+    return fileOf(sq);
+}
+
+constexpr int cordsY(int sq) {
+    return 7 - rankOf(sq);
+}
+
+// Bit twiddling
+
+constexpr Bitboard squareBB(int sq) {
+    return 1ULL << sq;
+}
+
+inline int popcount(Bitboard b) {
+    return std::popcount(b);
+}
+
+inline int lsb(Bitboard b) {
+    return std::countr_zero(b);
+}
+
+inline int popLsb(Bitboard& b) {
+    int sq = lsb(b);
+    b &= b - 1;
+    return sq;
+}
@@ -2,56 +2,137 @@
 
 // Constructor
 
-Board::Board(Uint16 size, Uint16 xsp, Uint16 ysp) : board_size(size), board_xsp(xsp), board_ysp(ysp), piece_manager(PieceManager::getInstance()), due_piece(nullptr), turn(true) {
+Board::Board(Uint16 size, Uint16 xsp, Uint16 ysp) : board_size(size), board_xsp(xsp), board_ysp(ysp), piece_manager(PieceManager::getInstance()), due_piece(nullptr),
+    background(nullptr), background_a({ 0, 0, 0, 0 }), background_b({ 0, 0, 0, 0 }), dirty(true) {
+}
+
+Board::~Board() {
+    SDL_DestroyTexture(background);
 }
 
 // Rendering method
 
-void Board::render_board(SDL_Renderer* renderer, SDL_Color a, SDL_Color b) {
+void Board::bake_background(SDL_Renderer* renderer, SDL_Color a, SDL_Color b) {
+    SDL_DestroyTexture(background);
+    background = nullptr;
+
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, 8, 8, 32, SDL_PIXELFORMAT_RGBA32);
+    if (surface == nullptr) {
+        return;
+    }
     for (int x = 0; x < 8; x++) {
         for (int y = 0; y < 8; y++) {
-            SDL_Rect rect = { board_xsp + x * board_size, board_ysp + y * board_size, board_size, board_size };
-            if ((x + y) % 2 == 0) {
-                helpers::SetRenderDrawColor(renderer, a);
-                SDL_RenderFillRect(renderer, &rect);
-            }
-            else {
-                helpers::SetRenderDrawColor(renderer, b);
-                SDL_RenderFillRect(renderer, &rect);
-            }
+            SDL_Color color = (x + y) % 2 == 0 ? a : b;
+            SDL_Rect cell = { x, y, 1, 1 };
+            SDL_FillRect(surface, &cell, SDL_MapRGBA(surface->format, color.r, color.g, color.b, color.a));
         }
     }
-    for (const auto& [a, b] : valid_moves) {
-        SDL_Rect rect = { board_xsp + a * board_size, board_ysp + b * board_size, board_size, board_size };
-        helpers::SetRenderDrawColor(renderer, { 255, 0, 0, 20 });
-        SDL_RenderFillRect(renderer, &rect);
+    background = SDL_CreateTextureFromSurface(renderer, surface);
+    SDL_FreeSurface(surface);
+    if (background) {
+        // Each texel is a whole square, it must not be smoothed into its neighbours
+        SDL_SetTextureScaleMode(background, SDL_ScaleModeNearest);
+    }
+    background_a = a;
+    background_b = b;
+}
+
+void Board::render_board(SDL_Renderer* renderer, SDL_Color a, SDL_Color b) {
+    PROFILE_FUNCTION();
+    auto same = [](SDL_Color l, SDL_Color r) { return l.r == r.r && l.g == r.g && l.b == r.b && l.a == r.a; };
+    if (!background || !same(a, background_a) || !same(b, background_b)) {
+        bake_background(renderer, a, b);
+    }
+    if (background) {
+        SDL_Rect rect = { board_xsp, board_ysp, 8 * board_size, 8 * board_size };
+        SDL_RenderCopy(renderer, background, nullptr, &rect);
+        helpers::countDrawCall();
     }
 }
 
 void Board::render_pieces() {
-    piece_manager->renderPieces();
+    PROFILE_FUNCTION();
+    batch.begin(Piece::atlas->getTexture());
+    for (const Move& move : valid_moves) {
+        SDL_Rect rect = { board_xsp + cordsX(move.getTo()) * board_size, board_ysp + cordsY(move.getTo()) * board_size, board_size, board_size };
+        batch.addQuad(rect, Piece::atlas->getSolidCell(), { 255, 0, 0, 20 });
+    }
+    piece_manager->renderPieces(batch);
+    batch.flush(Piece::renderer);
+}
+
+// Redraw tracking
+
+bool Board::isDirty() const {
+    return dirty;
+}
+
+void Board::markDirty() {
+    dirty = true;
+}
+
+void Board::clearDirty() {
+    dirty = false;
+}
+
+// Engine methods
+
+const Position& Board::getPosition() const {
+    return piece_manager->getPosition();
+}
+
+bool Board::setPosition(const std::string& fen) {
+    if (!piece_manager->setPosition(fen)) {
+        return false;
+    }
+    valid_moves.clear();
+    due_piece = nullptr;
+    dirty = true;
+    return true;
+}
+
+bool Board::applyEngineMove(Move move, uint64_t positionKey) {
+    if (move.isNull() || positionKey != piece_manager->getPosition().getKey()) {
+        return false;
+    }
+    piece_manager->movePiece(move);
+    valid_moves.clear();
+    due_piece = nullptr;
+    dirty = true;
+    return true;
 }
 
 // Mouse methods
 
 void Board::mouseDown(int x, int y) {
+    PROFILE_FUNCTION();
+    // Cell under the cursor, clicks beside the board are ignored
+    if (x < board_xsp || y < board_ysp) {
+        return;
+    }
+    int i = (x - board_xsp) / board_size;
+    int j = (y - board_ysp) / board_size;
+    if (i >= BOARD_LENGTH || j >= BOARD_LENGTH) {
+        return;
+    }
+    // Highlights only change when a piece was or becomes selected
+    bool hadSelection = due_piece != nullptr;
     // Check if the click is on a valid move
-    int i = x / 100;
-    int j = y / 100;
     if (due_piece) {
-        for (const auto& [a, b] : valid_moves) {
-            if (a == i && b == j) {
-                piece_manager->movePiece(due_piece, i, j);
+        for (const Move& move : valid_moves) {
+            // Promotions from the board always pick a queen
+            if (move.getTo() == squareFromCords(i, j) && (!move.isPromotion() || move.getPromotion() == QUEEN)) {
+                piece_manager->movePiece(move);
                 valid_moves.clear();
-                turn = !turn;
                 due_piece = nullptr;
+                dirty = true;
                 return;
             }
         }
         due_piece = piece_manager->getPiece(i, j);
         if (due_piece) {
-            if (!(due_piece->getIsWhite() ^ turn)) {
-                valid_moves = piece_manager->mouseDown(due_piece, x, y);
+            if (due_piece->getIsWhite() == piece_manager->isWhiteToMove()) {
+                piece_manager->mouseDown(due_piece, x, y, valid_moves);
             }
             else {
                 valid_moves.clear();
@@ -62,12 +143,15 @@ void Board::mouseDown(int x, int y) {
     else {
         due_piece = piece_manager->getPiece(i, j);
         if (due_piece) {
-            if (!(due_piece->getIsWhite() ^ turn)) {
-                valid_moves = piece_manager->mouseDown(due_piece, x, y);
+            if (due_piece->getIsWhite() == piece_manager->isWhiteToMove()) {
+                piece_manager->mouseDown(due_piece, x, y, valid_moves);
             }
             else {
                 due_piece = nullptr;
             }
 		}
     }
+    if (hadSelection || due_piece) {
+        dirty = true;
+    }
 }
\ No newline at end of file
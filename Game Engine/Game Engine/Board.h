@@ -8,16 +8,39 @@ class Board {
     Uint16 board_xsp;
     Uint16 board_ysp;
 
-    bool turn; // True for white's turn
-
     Piece* due_piece;
     PieceManager* piece_manager;
-    std::vector<std::pair<int, int>> valid_moves;
+    MoveList valid_moves; // Moves of due_piece, kept on the stack
+
+    // The squares never change, they are baked once into an 8x8 texture and stretched
+    SDL_Texture* background;
+    SDL_Color background_a;
+    SDL_Color background_b;
+    RenderBatch batch;
+    bool dirty; // Something on screen changed since the last frame
+
+    void bake_background(SDL_Renderer* renderer, SDL_Color a, SDL_Color b);
 public:
     Board(Uint16 size, Uint16 xsp, Uint16 ysp);
+    ~Board();
+    Board(const Board&) = delete;
+    Board& operator=(const Board&) = delete;
 
+    // One copy of the cached background
     void render_board(SDL_Renderer* renderer, SDL_Color a, SDL_Color b);
+    // Move highlights and every piece in a single geometry call from the atlas
     void render_pieces();
 
     void mouseDown(int x, int y);
+
+    const Position& getPosition() const;
+    bool setPosition(const std::string& fen);
+
+    // Frames are only drawn when the board asks for it
+    bool isDirty() const;
+    void markDirty();
+    void clearDirty();
+
+    // Plays a move found by the engine, unless the position changed since it was asked
+    bool applyEngineMove(Move move, uint64_t positionKey);
 };
\ No newline at end of file
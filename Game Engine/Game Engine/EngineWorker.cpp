@@ -0,0 +1,271 @@
+#include "EngineWorker.h"
+#include <algorithm>
+#include "Tablebase.h"
+
+// Constructor
+
+EngineWorker::EngineWorker(size_t hashMb, int threads) : tt(hashMb), search(tt, threads), useBook(true), bookRandom(std::random_device()()), currentKey(0), jobPending(false), running(false), openEnded(false), quitting(false), searching(false) {
+    // The callback runs on the search main thread, which is this worker's thread,
+    // so the queue keeps a single producer
+    search.setInfoCallback([this](const SearchInfo& info) {
+        EngineEvent event = {};
+        event.type = EngineEvent::INFO;
+        event.positionKey = currentKey;
+        event.depth = info.depth;
+        event.selDepth = info.selDepth;
+        event.score = info.score;
+        event.nodes = info.nodes;
+        event.tbHits = info.tbHits;
+        event.timeMs = info.timeMs;
+        event.bestMove = info.pv.empty() ? Move() : info.pv[0];
+        event.ponderMove = info.pv.size() > 1 ? info.pv[1] : Move();
+        event.pvLength = int(std::min<size_t>(info.pv.size(), ENGINE_EVENT_PV));
+        std::copy(info.pv.begin(), info.pv.begin() + event.pvLength, event.pv);
+        publish(event, false);
+    });
+    thread = std::thread(&EngineWorker::loop, this);
+}
+
+EngineWorker::~EngineWorker() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quitting = true;
+        jobPending = false;
+        if (running) {
+            search.stop();
+        }
+    }
+    wakeUp.notify_one();
+    idle.notify_all();
+    thread.join();
+}
+
+// Worker thread
+
+void EngineWorker::loop() {
+    Job current;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeUp.wait(lock, [this] { return jobPending || quitting; });
+            if (quitting) {
+                return;
+            }
+            current = job;
+            currentKey = current.position.getKey();
+            jobPending = false;
+            running = true;
+            openEnded = current.ponder || current.limits.infinite;
+            // Any stop issued from here on is meant for this search
+            search.clearStop();
+            search.setPondering(current.ponder);
+            if (current.stopped) {
+                search.stop();
+            }
+        }
+
+        EngineEvent event = {};
+        event.type = EngineEvent::BEST_MOVE;
+        event.positionKey = currentKey;
+        if (useBook && book.isOpen() && !current.ponder && !current.limits.infinite) {
+            event.bestMove = book.pick(current.position, bookRandom());
+            event.fromBook = !event.bestMove.isNull();
+        }
+
+        if (!event.fromBook) {
+            Move best = search.think(current.position, current.limits);
+
+            const SearchInfo& info = search.getLastInfo();
+            event.depth = info.depth;
+            event.selDepth = info.selDepth;
+            event.score = info.score;
+            event.nodes = info.nodes;
+            event.tbHits = info.tbHits;
+            event.timeMs = info.timeMs;
+            event.bestMove = best;
+            event.ponderMove = info.pv.size() > 1 && info.pv[0] == best ? info.pv[1] : Move();
+        }
+        // Idle before the reply goes out, an owner reacting to it with a setting must find
+        // the worker ready for it. Searching stays set until the reply is queued.
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+            openEnded = false;
+        }
+        idle.notify_all();
+        publish(event, true);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running && !jobPending) {
+            searching = false;
+        }
+    }
+}
+
+bool EngineWorker::waitIdle(std::unique_lock<std::mutex>& lock) {
+    // A ponder or infinite search only ends on a command from the thread that would be waiting
+    idle.wait(lock, [this] {
+        return (!running && !jobPending) || quitting || (running && openEnded)
+            || (jobPending && !job.stopped && (job.ponder || job.limits.infinite));
+    });
+    return !running && !jobPending && !quitting;
+}
+
+// Infos may be dropped when the owner falls behind, a best move never is
+void EngineWorker::publish(const EngineEvent& event, bool mustArrive) {
+    while (!events.push(event)) {
+        if (!mustArrive || quitting) {
+            return;
+        }
+        std::this_thread::yield();
+    }
+    if (onEvent) {
+        onEvent();
+    }
+}
+
+// Commands
+
+void EngineWorker::start(const Position& position, const SearchLimits& limits) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job.position = position;
+        job.limits = limits;
+        job.ponder = false;
+        job.stopped = false;
+        jobPending = true;
+        searching = true;
+        if (running) {
+            search.stop();
+            openEnded = false;
+        }
+    }
+    wakeUp.notify_one();
+}
+
+void EngineWorker::ponder(const Position& position, const SearchLimits& limits) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job.position = position;
+        job.limits = limits;
+        job.ponder = true;
+        job.stopped = false;
+        jobPending = true;
+        searching = true;
+        if (running) {
+            search.stop();
+            openEnded = false;
+        }
+    }
+    wakeUp.notify_one();
+}
+
+void EngineWorker::ponderHit() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (jobPending) {
+        job.ponder = false;
+    }
+    else {
+        search.ponderHit();
+        openEnded = running && job.limits.infinite;
+    }
+}
+
+void EngineWorker::stop() {
+    std::lock_guard<std::mutex> lock(mutex);
+    // A job not picked up yet still runs, stopped at once, so its caller gets a reply
+    if (jobPending) {
+        job.stopped = true;
+    }
+    if (running) {
+        search.stop();
+        openEnded = false;
+    }
+}
+
+bool EngineWorker::poll(EngineEvent& event) {
+    return events.pop(event);
+}
+
+void EngineWorker::setEventCallback(std::function<void()> callback) {
+    onEvent = callback;
+}
+
+bool EngineWorker::isSearching() const {
+    return searching;
+}
+
+// Settings
+
+bool EngineWorker::setThreads(int count) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!waitIdle(lock)) {
+        return false;
+    }
+    search.setThreads(count);
+    return true;
+}
+
+bool EngineWorker::setHash(size_t megabytes, bool& allocated) {
+    std::unique_lock<std::mutex> lock(mutex);
+    allocated = true;
+    if (!waitIdle(lock)) {
+        return false;
+    }
+    allocated = tt.resize(megabytes);
+    return true;
+}
+
+bool EngineWorker::setEvalFile(const std::string& path) {
+    std::unique_lock<std::mutex> lock(mutex);
+    return waitIdle(lock) && nnue::load(path);
+}
+
+bool EngineWorker::setUseNnue(bool value) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!waitIdle(lock)) {
+        return false;
+    }
+    nnue::setEnabled(value);
+    return true;
+}
+
+bool EngineWorker::setBookFile(const std::string& path) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!waitIdle(lock)) {
+        return false;
+    }
+    if (path.empty()) {
+        book.close();
+        return true;
+    }
+    return book.open(path);
+}
+
+bool EngineWorker::setUseBook(bool value) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!waitIdle(lock)) {
+        return false;
+    }
+    useBook = value;
+    return true;
+}
+
+bool EngineWorker::setSyzygyPath(const std::string& paths) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!waitIdle(lock)) {
+        return false;
+    }
+    tablebase::init(paths);
+    return true;
+}
+
+bool EngineWorker::clear() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!waitIdle(lock)) {
+        return false;
+    }
+    tt.clear();
+    search.clearHistory();
+    return true;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include "OpeningBook.h"
+#include "Search.h"
+#include "SpscQueue.h"
+
+#define ENGINE_EVENT_PV 32
+#define ENGINE_EVENT_QUEUE 256
+
+// Message from the engine thread, plain data so it can go through the lock-free queue
+struct EngineEvent {
+    enum Type : uint8_t { INFO, BEST_MOVE };
+
+    Type type;
+    uint64_t positionKey; // Key of the searched position, results for a stale position can be dropped
+    int depth;
+    int selDepth;
+    int score;
+    uint64_t nodes;
+    uint64_t tbHits;
+    int64_t timeMs;
+    Move bestMove;
+    Move ponderMove;
+    bool fromBook; // Best move taken from the opening book, nothing was searched
+    int pvLength;
+    Move pv[ENGINE_EVENT_PV];
+};
+
+// Runs the search on its own thread(s) so the caller never blocks. Commands are handed
+// over under a mutex (they are rare), results and iteration infos come back through a
+// lock-free queue that the owner polls, e.g. once per frame from the SDL loop.
+
+class EngineWorker {
+    struct Job {
+        Position position;
+        SearchLimits limits;
+        bool ponder;
+        bool stopped; // Stopped before it began, searched only for its reply
+    };
+
+    TranspositionTable tt;
+    Search search;
+    OpeningBook book;
+    bool useBook;
+    std::mt19937_64 bookRandom;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::condition_variable idle;
+    Job job;
+    uint64_t currentKey; // Key of the position being searched, only touched by the worker
+    bool jobPending;
+    bool running;
+    bool openEnded; // The running search ponders or is infinite, only a command ends it
+    std::atomic<bool> quitting; // Also read by publish() without the lock
+    std::atomic<bool> searching;
+
+    SpscQueue<EngineEvent, ENGINE_EVENT_QUEUE> events;
+    std::function<void()> onEvent;
+
+    void loop();
+    void publish(const EngineEvent& event, bool mustArrive);
+    bool waitIdle(std::unique_lock<std::mutex>& lock);
+public:
+    EngineWorker(size_t hashMb = DEFAULT_HASH_MB, int threads = 1);
+    ~EngineWorker();
+    EngineWorker(const EngineWorker&) = delete;
+    EngineWorker& operator=(const EngineWorker&) = delete;
+
+    // Starts searching a copy of the position, a running search is stopped first. Every search
+    // started is answered by exactly one BEST_MOVE, even if it is stopped before it begins,
+    // unless another start replaces it before the worker picked it up.
+    void start(const Position& position, const SearchLimits& limits);
+    // Same, but ignores the clock until ponderHit() and holds the result until then or stop()
+    void ponder(const Position& position, const SearchLimits& limits);
+    void ponderHit();
+    void stop();
+
+    // Pops the next event, never blocks
+    bool poll(EngineEvent& event);
+    // Called on the worker thread after an event is queued, lets an owner that waits on
+    // something else wake up instead of polling. Set it before the first search.
+    void setEventCallback(std::function<void()> callback);
+    bool isSearching() const;
+
+    // Settings wait for the searches started so far to end. They are false without waiting
+    // when one of them ponders or is infinite, and so only ends on stop() or ponderHit().
+    bool setThreads(int count);
+    // allocated is false when the memory is not there, the old table is kept then
+    bool setHash(size_t megabytes, bool& allocated);
+    bool clear();
+    // The network is process wide, false if busy or the file does not load
+    bool setEvalFile(const std::string& path);
+    bool setUseNnue(bool value);
+    // Searches not pondering nor infinite are answered from the book when it has the position.
+    // An empty path closes the book, false if busy or the file is not a Polyglot book.
+    bool setBookFile(const std::string& path);
+    bool setUseBook(bool value);
+    // Syzygy directories separated by ':' (';' on Windows), empty for none. The tables are
+    // process wide, false if busy.
+    bool setSyzygyPath(const std::string& paths);
+};
@@ -0,0 +1,248 @@
+#include "Evaluation.h"
+#include <algorithm>
+#include <array>
+
+namespace eval {
+    alignas(32) const int32_t WEIGHTS_MG[FEATURE_NB] = {
+        4, 5, 2, 1,                 // Mobility, per square
+        -10, -10, -8,               // Doubled, isolated, backward
+        5, 10, 15, 30, 50, 80, 0,   // Passed pawn by rank, passed pawn with a free stop square
+        15, -20, 6,                 // King shield, open files by the king, attacks on the enemy king zone
+        30, 25, 10,                 // Bishop pair, rook on open and semi-open file
+    };
+
+    alignas(32) const int32_t WEIGHTS_EG[FEATURE_NB] = {
+        4, 5, 4, 2,
+        -20, -15, -10,
+        10, 15, 30, 55, 90, 140, 15,
+        0, 0, 2,
+        50, 10, 5,
+    };
+
+    namespace {
+        constexpr Bitboard fileBB(int file) {
+            return FILE_A_BB << file;
+        }
+
+        constexpr Bitboard adjacentFiles(int file) {
+            return (file > 0 ? fileBB(file - 1) : 0) | (file < 7 ? fileBB(file + 1) : 0);
+        }
+
+        // Squares strictly in front of sq for the color, on its own file
+        constexpr std::array<std::array<Bitboard, 64>, COLOR_NB> makeForwardTable() {
+            std::array<std::array<Bitboard, 64>, COLOR_NB> table{};
+            for (int sq = 0; sq < 64; sq++) {
+                for (int r = rankOf(sq) + 1; r < 8; r++) {
+                    table[WHITE][sq] |= squareBB(makeSquare(fileOf(sq), r));
+                }
+                for (int r = rankOf(sq) - 1; r >= 0; r--) {
+                    table[BLACK][sq] |= squareBB(makeSquare(fileOf(sq), r));
+                }
+            }
+            return table;
+        }
+
+        constexpr std::array<std::array<Bitboard, 64>, COLOR_NB> FORWARD = makeForwardTable();
+
+        // Front span over the pawn's and the adjacent files, an enemy pawn in it stops a passer
+        constexpr std::array<std::array<Bitboard, 64>, COLOR_NB> makePassedTable() {
+            std::array<std::array<Bitboard, 64>, COLOR_NB> table{};
+            for (int c = WHITE; c <= BLACK; c++) {
+                for (int sq = 0; sq < 64; sq++) {
+                    Bitboard front = FORWARD[c][sq];
+                    table[c][sq] = front | ((front & ~FILE_H_BB) << 1) | ((front & ~FILE_A_BB) >> 1);
+                }
+            }
+            return table;
+        }
+
+        constexpr std::array<std::array<Bitboard, 64>, COLOR_NB> PASSED_SPAN = makePassedTable();
+
+        // Ranks from the color's own side, rank 0 is its back rank
+        constexpr int relativeRank(Color c, int sq) {
+            return c == WHITE ? rankOf(sq) : 7 - rankOf(sq);
+        }
+
+        Bitboard pawnAttacksBB(Color c, Bitboard pawns) {
+            return c == WHITE ? ((pawns & ~FILE_A_BB) << 7) | ((pawns & ~FILE_H_BB) << 9)
+                : ((pawns & ~FILE_A_BB) >> 9) | ((pawns & ~FILE_H_BB) >> 7);
+        }
+
+        // Counts the pawn-only terms, returns the passed pawns
+        Bitboard pawnFeatures(const Position& position, Color us, int32_t* counts) {
+            Color them = Color(us ^ 1);
+            Bitboard ours = position.getPieces(us, PAWN);
+            Bitboard theirs = position.getPieces(them, PAWN);
+            Bitboard theirAttacks = pawnAttacksBB(them, theirs);
+            Bitboard passed = 0;
+
+            Bitboard b = ours;
+            while (b) {
+                int sq = popLsb(b);
+                Bitboard neighbours = ours & adjacentFiles(fileOf(sq));
+
+                counts[DOUBLED_PAWNS] += (ours & FORWARD[us][sq]) != 0;
+                counts[ISOLATED_PAWNS] += neighbours == 0;
+                if (!(theirs & PASSED_SPAN[us][sq])) {
+                    counts[PASSED_RANK_2 + relativeRank(us, sq) - 1]++;
+                    passed |= squareBB(sq);
+                }
+
+                // Backward: every neighbour is already past it and the stop square is covered by an enemy pawn.
+                // The passed span seen from the stop square backwards covers the neighbours level or behind.
+                int stop = us == WHITE ? sq + 8 : sq - 8;
+                Bitboard levelOrBehind = PASSED_SPAN[them][stop] & ~fileBB(fileOf(sq));
+                if (neighbours && !(neighbours & levelOrBehind) && (theirAttacks & squareBB(stop))) {
+                    counts[BACKWARD_PAWNS]++;
+                }
+            }
+            return passed;
+        }
+
+        void kingFeatures(const Position& position, Color us, int32_t* counts) {
+            int king = position.getKingSquare(us);
+            Bitboard ours = position.getPieces(us, PAWN);
+            int file = fileOf(king);
+            Bitboard files = fileBB(file) | adjacentFiles(file);
+
+            // Own pawns on the king's and the neighbouring files, one or two ranks ahead
+            Bitboard shield = 0;
+            for (int r = 1; r <= 2; r++) {
+                int rank = us == WHITE ? rankOf(king) + r : rankOf(king) - r;
+                if (rank >= 0 && rank < 8) {
+                    shield |= RANK_1_BB << (8 * rank);
+                }
+            }
+            counts[KING_SHIELD] += popcount(ours & files & shield);
+
+            for (int f = std::max(0, file - 1); f <= std::min(7, file + 1); f++) {
+                counts[KING_OPEN_FILES] += !(ours & fileBB(f));
+            }
+        }
+
+        // Terms that depend on more than the pawns and the king, never cached
+        void pieceFeatures(const Position& position, Color us, Bitboard passed, int32_t* counts) {
+            Color them = Color(us ^ 1);
+            Bitboard occupied = position.getOccupied();
+            Bitboard area = ~position.getPieces(us) & ~pawnAttacksBB(them, position.getPieces(them, PAWN));
+            int theirKing = position.getKingSquare(them);
+            Bitboard kingZone = attacks::kingAttacks(theirKing) | squareBB(theirKing);
+            Bitboard allPawns = position.getPieces(WHITE, PAWN) | position.getPieces(BLACK, PAWN);
+
+            Bitboard attacked = pawnAttacksBB(us, position.getPieces(us, PAWN)) & kingZone;
+            counts[KING_ZONE_ATTACKS] += popcount(attacked);
+
+            for (int pt = KNIGHT; pt <= QUEEN; pt++) {
+                Bitboard b = position.getPieces(us, PieceType(pt));
+                while (b) {
+                    int sq = popLsb(b);
+                    Bitboard att = pt == KNIGHT ? attacks::knightAttacks(sq)
+                        : pt == BISHOP ? attacks::bishopAttacks(sq, occupied)
+                        : pt == ROOK ? attacks::rookAttacks(sq, occupied)
+                        : attacks::queenAttacks(sq, occupied);
+                    counts[KNIGHT_MOBILITY + pt - KNIGHT] += popcount(att & area);
+                    counts[KING_ZONE_ATTACKS] += popcount(att & kingZone);
+
+                    if (pt == ROOK) {
+                        Bitboard file = fileBB(fileOf(sq));
+                        if (!(allPawns & file)) {
+                            counts[ROOK_OPEN_FILE]++;
+                        }
+                        else if (!(position.getPieces(us, PAWN) & file)) {
+                            counts[ROOK_SEMI_OPEN_FILE]++;
+                        }
+                    }
+                }
+            }
+            counts[BISHOP_PAIR] += popcount(position.getPieces(us, BISHOP)) >= 2;
+
+            Bitboard stops = us == WHITE ? passed << 8 : passed >> 8;
+            counts[PASSED_FREE] += popcount(stops & ~occupied);
+        }
+
+        // Midgame and endgame sums of one color's row of counts
+        Score rowScore(const int32_t* counts) {
+            int mg = 0;
+            int eg = 0;
+            for (int i = 0; i < FEATURE_NB; i++) {
+                mg += counts[i] * WEIGHTS_MG[i];
+                eg += counts[i] * WEIGHTS_EG[i];
+            }
+            return makeScore(mg, eg);
+        }
+
+        // Pawn structure and shelter through the cache, returns the white relative score
+        Score cachedPawnScore(const Position& position, PawnTable& pawns, Bitboard passed[COLOR_NB]) {
+            bool found;
+            PawnEntry& entry = pawns.probe(position.getPawnKey(), found);
+            if (!found) {
+                Features pawnOnly = Features();
+                entry.key = position.getPawnKey();
+                for (Color c : { WHITE, BLACK }) {
+                    entry.passed[c] = pawnFeatures(position, c, pawnOnly.counts[c]);
+                    entry.kingSquare[c] = NO_SQUARE;
+                }
+                entry.score = rowScore(pawnOnly.counts[WHITE]) - rowScore(pawnOnly.counts[BLACK]);
+            }
+
+            // Kings move far more often than pawns, only the shelter of a moved king is redone
+            for (Color c : { WHITE, BLACK }) {
+                int king = position.getKingSquare(c);
+                if (entry.kingSquare[c] != king) {
+                    int32_t counts[FEATURE_NB] = {};
+                    kingFeatures(position, c, counts);
+                    entry.shelter[c] = rowScore(counts);
+                    entry.kingSquare[c] = king;
+                }
+                passed[c] = entry.passed[c];
+            }
+            return entry.score + entry.shelter[WHITE] - entry.shelter[BLACK];
+        }
+    }
+
+    void extractFeatures(const Position& position, Features& features) {
+        features = Features();
+        for (Color c : { WHITE, BLACK }) {
+            Bitboard passed = pawnFeatures(position, c, features.counts[c]);
+            kingFeatures(position, c, features.counts[c]);
+            pieceFeatures(position, c, passed, features.counts[c]);
+        }
+    }
+
+    int evaluate(const Position& position, PawnTable* pawns) {
+        if (nnue::isEnabled()) {
+            return nnue::evaluate(position);
+        }
+
+        Features features = Features();
+        Score pawnScore = 0;
+        Bitboard passed[COLOR_NB];
+        if (pawns) {
+            pawnScore = cachedPawnScore(position, *pawns, passed);
+        }
+        else {
+            for (Color c : { WHITE, BLACK }) {
+                passed[c] = pawnFeatures(position, c, features.counts[c]);
+                kingFeatures(position, c, features.counts[c]);
+            }
+        }
+        for (Color c : { WHITE, BLACK }) {
+            pieceFeatures(position, c, passed[c], features.counts[c]);
+        }
+
+        // Material and piece-square terms come for free, Position keeps their sum
+        Score base = position.getPsqtScore() + pawnScore;
+        int mg = mgValue(base);
+        int eg = egValue(base);
+        for (int i = 0; i < FEATURE_NB; i++) {
+            int32_t diff = features.counts[WHITE][i] - features.counts[BLACK][i];
+            mg += diff * WEIGHTS_MG[i];
+            eg += diff * WEIGHTS_EG[i];
+        }
+
+        // Taper between the two by the material left on the board
+        int phase = std::min(position.getPhase(), PHASE_MAX);
+        int score = (mg * phase + eg * (PHASE_MAX - phase)) / PHASE_MAX;
+        return (position.getSideToMove() == WHITE ? score : -score) + TEMPO_BONUS;
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include "Position.h"
+#include "PawnTable.h"
+
+#define TEMPO_BONUS 10
+
+namespace eval {
+    constexpr int PIECE_VALUES[PIECE_TYPE_NB] = { 100, 320, 330, 500, 900, 0 };
+
+    // Everything beyond material and piece-square tables is a linear term: a count per side
+    // (mobile squares, isolated pawns, ...) times a midgame and an endgame weight
+    enum Feature : int {
+        KNIGHT_MOBILITY, BISHOP_MOBILITY, ROOK_MOBILITY, QUEEN_MOBILITY,
+        DOUBLED_PAWNS, ISOLATED_PAWNS, BACKWARD_PAWNS,
+        PASSED_RANK_2, PASSED_RANK_3, PASSED_RANK_4, PASSED_RANK_5, PASSED_RANK_6, PASSED_RANK_7, PASSED_FREE,
+        KING_SHIELD, KING_OPEN_FILES, KING_ZONE_ATTACKS,
+        BISHOP_PAIR, ROOK_OPEN_FILE, ROOK_SEMI_OPEN_FILE,
+        FEATURE_NB
+    };
+
+    // Struct of arrays: one contiguous row of counts per color, scored with a dot product
+    // against the weight rows, which the compiler turns into a few vector multiply-adds
+    struct Features {
+        alignas(32) int32_t counts[COLOR_NB][FEATURE_NB];
+    };
+
+    extern const int32_t WEIGHTS_MG[FEATURE_NB];
+    extern const int32_t WEIGHTS_EG[FEATURE_NB];
+
+    // Every count from scratch, without the pawn cache
+    void extractFeatures(const Position& position, Features& features);
+
+    // Static score in centipawns from the point of view of the side to move. With a pawn
+    // table the pawn structure and king shelter terms come from the cache when possible.
+    // Hands over to the network instead while one is loaded and enabled.
+    int evaluate(const Position& position, PawnTable* pawns = nullptr);
+}
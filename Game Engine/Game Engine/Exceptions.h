@@ -54,4 +54,15 @@ public:
 	const char* what() const throw() {
 		return message.c_str();
 	}
+};
+
+class UnableToBuildAtlas : public std::exception {
+	std::string message;
+public:
+	UnableToBuildAtlas(const std::string& directory) {
+		message = "Unable to build the texture atlas from " + directory + "! SDL Error: " + SDL_GetError();
+	}
+	const char* what() const throw() {
+		return message.c_str();
+	}
 };
\ No newline at end of file
@@ -3,6 +3,8 @@
 namespace helpers {
     SDL_Renderer* gRenderer = nullptr;
     SDL_Window* gWindow = nullptr;
+    SDL_Surface* gTarget = nullptr;
+    Uint32 gDrawCalls = 0;
 
     Uint8 init(SDL_Renderer*& renderer, SDL_Window*& window, Uint16 SCREEN_WIDTH, Uint16 SCREEN_HEIGHT) {
         // Initialize SDL
@@ -39,14 +41,71 @@ namespace helpers {
         return 0;
     }
 
+    Uint8 initHeadless(SDL_Renderer*& renderer, SDL_Surface*& target, Uint16 SCREEN_WIDTH, Uint16 SCREEN_HEIGHT) {
+        // The dummy video driver works without a display, nothing is ever shown
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+        if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+            std::cout << "SDL could not initialize! SDL_Error: " << SDL_GetError() << std::endl;
+            return 1;
+        }
+
+        if (!(IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG)) {
+            std::cout << "SDL_image could not initialize! SDL_image Error: " << IMG_GetError() << std::endl;
+            SDL_Quit();
+            return 1;
+        }
+
+        target = SDL_CreateRGBSurfaceWithFormat(0, SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_PIXELFORMAT_RGBA32);
+        if (target == nullptr) {
+            std::cout << "Target surface could not be created! SDL_Error: " << SDL_GetError() << std::endl;
+            IMG_Quit();
+            SDL_Quit();
+            return 1;
+        }
+        gTarget = target;
+
+        renderer = SDL_CreateSoftwareRenderer(target);
+        if (renderer == nullptr) {
+            std::cout << "Software renderer could not be created! SDL_Error: " << SDL_GetError() << std::endl;
+            SDL_FreeSurface(target);
+            IMG_Quit();
+            SDL_Quit();
+            return 1;
+        }
+        gRenderer = renderer;
+
+        return 0;
+    }
+
     void quit() {
         SDL_DestroyRenderer(gRenderer);
         SDL_DestroyWindow(gWindow);
+        SDL_FreeSurface(gTarget);
         IMG_Quit();
         SDL_Quit();
     }
 
+    bool savePNG(SDL_Surface* surface, const std::string& path) {
+        if (IMG_SavePNG(surface, path.c_str()) < 0) {
+            std::cout << "Unable to save " << path << "! SDL_image Error: " << IMG_GetError() << std::endl;
+            return false;
+        }
+        return true;
+    }
+
     void SetRenderDrawColor(SDL_Renderer* renderer, SDL_Color color) {
         SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
     }
+
+    void countDrawCall() {
+        gDrawCalls++;
+    }
+
+    Uint32 getDrawCalls() {
+        return gDrawCalls;
+    }
+
+    void resetDrawCalls() {
+        gDrawCalls = 0;
+    }
 }
\ No newline at end of file
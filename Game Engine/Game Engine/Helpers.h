@@ -8,6 +8,14 @@
 
 namespace helpers {
     Uint8 init(SDL_Renderer*& renderer, SDL_Window*& window, Uint16 SCREEN_WIDTH, Uint16 SCREEN_HEIGHT);
+    // No window: SDL's software renderer draws into an offscreen RGBA surface, for benchmarks and CI
+    Uint8 initHeadless(SDL_Renderer*& renderer, SDL_Surface*& target, Uint16 SCREEN_WIDTH, Uint16 SCREEN_HEIGHT);
     void SetRenderDrawColor(SDL_Renderer* renderer, SDL_Color color);
     void quit();
+    bool savePNG(SDL_Surface* surface, const std::string& path);
+
+    // Draw call accounting, every SDL_Render* submission of a frame goes through countDrawCall
+    void countDrawCall();
+    Uint32 getDrawCalls();
+    void resetDrawCalls();
 }
\ No newline at end of file
@@ -0,0 +1,67 @@
+#include "HitMask.h"
+
+// Constructors
+
+HitMask::HitMask() : width(0), height(0) {
+}
+
+HitMask::HitMask(int width, int height) : width(width), height(height), bits((size_t(width) * height + 63) / 64, 0) {
+}
+
+HitMask HitMask::fromAlpha(const SDL_Surface* surface, const SDL_Rect& cell) {
+    HitMask mask(cell.w, cell.h);
+    const Uint32* pixels = (const Uint32*)surface->pixels;
+    int stride = surface->pitch / 4;
+    for (int y = 0; y < cell.h; y++) {
+        for (int x = 0; x < cell.w; x++) {
+            Uint32 pixel = pixels[(cell.y + y) * stride + cell.x + x];
+            Uint8 alpha = (pixel & surface->format->Amask) >> surface->format->Ashift;
+            if (alpha > ALPHA_THRESHOLD) {
+                mask.set(x, y);
+            }
+        }
+    }
+    return mask;
+}
+
+HitMask HitMask::scaled(int newWidth, int newHeight) const {
+    HitMask mask(newWidth, newHeight);
+    for (int y = 0; y < newHeight; y++) {
+        int sourceY = y * height / newHeight;
+        for (int x = 0; x < newWidth; x++) {
+            if (test(x * width / newWidth, sourceY)) {
+                mask.set(x, y);
+            }
+        }
+    }
+    return mask;
+}
+
+// Bits
+
+void HitMask::set(int x, int y) {
+    size_t index = size_t(y) * width + x;
+    bits[index / 64] |= 1ULL << (index % 64);
+}
+
+bool HitMask::test(int x, int y) const {
+    if (x < 0 || x >= width || y < 0 || y >= height) {
+        return false;
+    }
+    size_t index = size_t(y) * width + x;
+    return (bits[index / 64] >> (index % 64)) & 1;
+}
+
+// Getters
+
+int HitMask::getWidth() const {
+    return width;
+}
+
+int HitMask::getHeight() const {
+    return height;
+}
+
+size_t HitMask::getBytes() const {
+    return bits.size() * sizeof(uint64_t);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <SDL.h>
+#include <cstdint>
+#include <vector>
+
+#define ALPHA_THRESHOLD 0 // Pixels more opaque than this can be clicked
+
+// Packed 1-bit opacity mask of a sprite, one bit per pixel, row major. Clicks are tested
+// against it instead of a retained RGBA surface.
+
+class HitMask {
+    int width;
+    int height;
+    std::vector<uint64_t> bits;
+public:
+    HitMask();
+    HitMask(int width, int height);
+
+    // Thresholds the alpha of the cell of an RGBA32 surface
+    static HitMask fromAlpha(const SDL_Surface* surface, const SDL_Rect& cell);
+
+    // Nearest-neighbour resample, used to match the mask to the on-screen cell size
+    HitMask scaled(int newWidth, int newHeight) const;
+
+    void set(int x, int y);
+    // Outside the mask counts as transparent
+    bool test(int x, int y) const;
+
+    int getWidth() const;
+    int getHeight() const;
+    size_t getBytes() const;
+};
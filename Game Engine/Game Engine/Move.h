@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "Bitboard.h"
+
+#define MAX_MOVES 256
+
+// Move flags, stored in the top 4 bits of a Move. Promotions keep the piece in the
+// low two bits (knight, bishop, rook, queen) and set the capture bit when they take.
+enum MoveFlag : int {
+    QUIET = 0,
+    DOUBLE_PUSH = 1,
+    KING_CASTLE = 2,
+    QUEEN_CASTLE = 3,
+    CAPTURE = 4,
+    EP_CAPTURE = 5,
+    PROMOTION = 8,
+    PROMOTION_CAPTURE = 12
+};
+
+// Packed 16 bit move: from (6 bits), to (6 bits), flags (4 bits)
+
+class Move {
+    uint16_t data;
+public:
+    constexpr Move() : data(0) {}
+    constexpr Move(int from, int to, int flags = QUIET) : data(uint16_t(from | (to << 6) | (flags << 12))) {}
+
+    constexpr int getFrom() const { return data & 0x3F; }
+    constexpr int getTo() const { return (data >> 6) & 0x3F; }
+    constexpr int getFlags() const { return data >> 12; }
+    constexpr uint16_t getRaw() const { return data; }
+
+    constexpr bool isNull() const { return data == 0; }
+    constexpr bool isCapture() const { return getFlags() & CAPTURE; }
+    constexpr bool isPromotion() const { return getFlags() & PROMOTION; }
+    constexpr PieceType getPromotion() const { return PieceType(KNIGHT + (getFlags() & 3)); }
+
+    // Long algebraic notation as used by UCI, e.g. e2e4 or e7e8q
+    std::string toString() const {
+        if (isNull()) {
+            return "0000";
+        }
+        std::string s = {
+            char('a' + fileOf(getFrom())), char('1' + rankOf(getFrom())),
+            char('a' + fileOf(getTo())), char('1' + rankOf(getTo()))
+        };
+        if (isPromotion()) {
+            s += "nbrq"[getPromotion() - KNIGHT];
+        }
+        return s;
+    }
+
+    constexpr bool operator==(const Move& other) const { return data == other.data; }
+    constexpr bool operator!=(const Move& other) const { return data != other.data; }
+};
+
+// Fixed capacity move list living on the stack, no position has more than 218 legal moves
+
+class MoveList {
+    Move moves[MAX_MOVES];
+    int count = 0;
+public:
+    void add(Move move) { moves[count++] = move; }
+    void clear() { count = 0; }
+
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    Move& operator[](int i) { return moves[i]; }
+    const Move& operator[](int i) const { return moves[i]; }
+
+    Move* begin() { return moves; }
+    Move* end() { return moves + count; }
+    const Move* begin() const { return moves; }
+    const Move* end() const { return moves + count; }
+};
@@ -0,0 +1,504 @@
+#include "MoveGen.h"
+#include "Attacks.h"
+
+// Legal move generation. Instead of playing each move and testing for check, the
+// generator computes up front:
+//  - checkers: enemy pieces giving check, two of them leave only king moves
+//  - checkMask: squares that capture or block a single checker (all squares when not in check)
+//  - pinned: our pieces shielding the king from a slider, they may only move along that line
+//  - danger: squares the enemy attacks with our king removed, the king may not step there
+
+namespace {
+    // Adds one move per target square, flagging the ones that land on an enemy piece
+    void addTargets(MoveList& moves, int from, Bitboard targets, Bitboard enemies) {
+        while (targets) {
+            int to = popLsb(targets);
+            moves.add(Move(from, to, (enemies & squareBB(to)) ? CAPTURE : QUIET));
+        }
+    }
+
+    void addPromotions(MoveList& moves, int from, int to, bool isCapture) {
+        int flags = isCapture ? PROMOTION_CAPTURE : PROMOTION;
+        moves.add(Move(from, to, flags | (QUEEN - KNIGHT)));
+        moves.add(Move(from, to, flags | (ROOK - KNIGHT)));
+        moves.add(Move(from, to, flags | (BISHOP - KNIGHT)));
+        moves.add(Move(from, to, flags | (KNIGHT - KNIGHT)));
+    }
+
+    Bitboard attackedSquares(const Position& position, Color by, Bitboard occupied) {
+        Bitboard result = 0;
+
+        Bitboard pawns = position.getPieces(by, PAWN);
+        result |= by == WHITE
+            ? ((pawns & ~FILE_A_BB) << 7) | ((pawns & ~FILE_H_BB) << 9)
+            : ((pawns & ~FILE_A_BB) >> 9) | ((pawns & ~FILE_H_BB) >> 7);
+
+        Bitboard knights = position.getPieces(by, KNIGHT);
+        while (knights) {
+            result |= attacks::knightAttacks(popLsb(knights));
+        }
+
+        Bitboard diagonal = position.getPieces(by, BISHOP) | position.getPieces(by, QUEEN);
+        while (diagonal) {
+            result |= attacks::bishopAttacks(popLsb(diagonal), occupied);
+        }
+
+        Bitboard straight = position.getPieces(by, ROOK) | position.getPieces(by, QUEEN);
+        while (straight) {
+            result |= attacks::rookAttacks(popLsb(straight), occupied);
+        }
+
+        return result | attacks::kingAttacks(position.getKingSquare(by));
+    }
+
+    // Restricts the targets of a pinned piece to the line through its king
+    Bitboard pinMask(const MoveGenState& st, int from) {
+        return (st.pinned & squareBB(from)) ? attacks::line(st.king, from) : ~0ULL;
+    }
+
+    void generatePawnMoves(const Position& position, const MoveGenState& st, MoveList& moves, MoveGenType type, Bitboard mask) {
+        Bitboard pawns = position.getPieces(st.us, PAWN) & mask;
+        Bitboard empty = ~st.occupied;
+        int up = st.us == WHITE ? 8 : -8;
+        Bitboard startRank = st.us == WHITE ? RANK_1_BB << 16 : RANK_1_BB << 40; // Ranks reached by a single push from the start
+        Bitboard lastRank = st.us == WHITE ? RANK_8_BB : RANK_1_BB;
+        bool noisy = type != QUIET_MOVES;
+        bool quiet = type != NOISY_MOVES;
+
+        // Pinned pawns are rare, so they are handled one by one and the rest set-wise
+        Bitboard free = pawns & ~st.pinned;
+        Bitboard single = (st.us == WHITE ? free << 8 : free >> 8) & empty;
+        Bitboard doubled = (st.us == WHITE ? (single & startRank) << 8 : (single & startRank) >> 8) & empty & st.checkMask;
+        single &= st.checkMask;
+
+        // Promotions count as noisy even without a capture
+        Bitboard promotions = noisy ? single & lastRank : 0;
+        single = quiet ? single & ~lastRank : 0;
+        doubled = quiet ? doubled : 0;
+        while (single) {
+            int to = popLsb(single);
+            moves.add(Move(to - up, to, QUIET));
+        }
+        while (promotions) {
+            int to = popLsb(promotions);
+            addPromotions(moves, to - up, to, false);
+        }
+        while (doubled) {
+            int to = popLsb(doubled);
+            moves.add(Move(to - 2 * up, to, DOUBLE_PUSH));
+        }
+
+        Bitboard pinnedPawns = pawns & st.pinned;
+        while (pinnedPawns) {
+            int from = popLsb(pinnedPawns);
+            Bitboard allowed = st.checkMask & attacks::line(st.king, from);
+            Bitboard push = squareBB(from + up) & empty;
+            Bitboard pushes = push & allowed;
+            if (push && (squareBB(from) & (st.us == WHITE ? RANK_1_BB << 8 : RANK_1_BB << 48))) {
+                pushes |= squareBB(from + 2 * up) & empty & allowed;
+            }
+            while (pushes) {
+                int to = popLsb(pushes);
+                if (squareBB(to) & lastRank) {
+                    if (noisy) {
+                        addPromotions(moves, from, to, false);
+                    }
+                }
+                else if (quiet) {
+                    moves.add(Move(from, to, to - from == 2 * up ? DOUBLE_PUSH : QUIET));
+                }
+            }
+        }
+
+        if (!noisy) {
+            return;
+        }
+        Bitboard capturers = pawns;
+        while (capturers) {
+            int from = popLsb(capturers);
+            Bitboard targets = attacks::pawnAttacks(st.us, from) & st.enemies & st.checkMask & pinMask(st, from);
+            while (targets) {
+                int to = popLsb(targets);
+                if (squareBB(to) & lastRank) {
+                    addPromotions(moves, from, to, true);
+                }
+                else {
+                    moves.add(Move(from, to, CAPTURE));
+                }
+            }
+        }
+
+        // En passant removes two pieces from one rank, which can expose the king to a
+        // slider even when neither pawn is pinned on its own, so it gets an exact test.
+        // The square is not trusted, the pawn it captures must be there.
+        int ep = position.getEnPassantSquare();
+        if (ep != NO_SQUARE) {
+            int captured = ep - up;
+            if ((position.getPieces(st.them, PAWN) & squareBB(captured)) && !(st.occupied & squareBB(ep))
+                && (st.checkMask & (squareBB(ep) | squareBB(captured)))) {
+                Bitboard candidates = attacks::pawnAttacks(st.them, ep) & pawns;
+                Bitboard straight = position.getPieces(st.them, ROOK) | position.getPieces(st.them, QUEEN);
+                Bitboard diagonal = position.getPieces(st.them, BISHOP) | position.getPieces(st.them, QUEEN);
+                while (candidates) {
+                    int from = popLsb(candidates);
+                    Bitboard after = (st.occupied ^ squareBB(from) ^ squareBB(captured)) | squareBB(ep);
+                    if (!(attacks::rookAttacks(st.king, after) & straight) && !(attacks::bishopAttacks(st.king, after) & diagonal)) {
+                        moves.add(Move(from, ep, EP_CAPTURE));
+                    }
+                }
+            }
+        }
+    }
+
+    void generateCastling(const Position& position, const MoveGenState& st, MoveList& moves) {
+        int rights = position.getCastlingRights() & (st.us == WHITE ? (WHITE_OO | WHITE_OOO) : (BLACK_OO | BLACK_OOO));
+        if (!rights || st.checkers) {
+            return;
+        }
+
+        // Rights come from outside too, the king and the rook must still be on their squares
+        int rank = st.us == WHITE ? 0 : 56;
+        PieceCode rook = makePiece(st.us, ROOK);
+        if (st.king != E1 + rank) {
+            return;
+        }
+        if ((rights & (WHITE_OO | BLACK_OO)) && position.pieceOn(H1 + rank) == rook
+            && !(st.occupied & (squareBB(F1 + rank) | squareBB(G1 + rank)))
+            && !(st.danger & (squareBB(F1 + rank) | squareBB(G1 + rank)))) {
+            moves.add(Move(st.king, G1 + rank, KING_CASTLE));
+        }
+        if ((rights & (WHITE_OOO | BLACK_OOO)) && position.pieceOn(A1 + rank) == rook
+            && !(st.occupied & (squareBB(B1 + rank) | squareBB(C1 + rank) | squareBB(D1 + rank)))
+            && !(st.danger & (squareBB(C1 + rank) | squareBB(D1 + rank)))) {
+            moves.add(Move(st.king, C1 + rank, QUEEN_CASTLE));
+        }
+    }
+
+    // Appends the moves of the given type of the pieces on the mask squares
+    void generate(const Position& position, const MoveGenState& st, MoveList& moves, MoveGenType type, Bitboard mask) {
+        Bitboard targets = type == NOISY_MOVES ? st.enemies : type == QUIET_MOVES ? ~st.occupied : ~st.own;
+        bool kingMoves = mask & squareBB(st.king);
+        if (kingMoves) {
+            addTargets(moves, st.king, attacks::kingAttacks(st.king) & targets & ~st.own & ~st.danger, st.enemies);
+        }
+
+        // In double check only the king can move
+        if (popcount(st.checkers) > 1) {
+            return;
+        }
+
+        generatePawnMoves(position, st, moves, type, mask);
+        if (kingMoves && type != NOISY_MOVES) {
+            generateCastling(position, st, moves);
+        }
+
+        Bitboard allowed = targets & ~st.own & st.checkMask;
+
+        // A pinned knight can never move
+        Bitboard knights = position.getPieces(st.us, KNIGHT) & ~st.pinned & mask;
+        while (knights) {
+            int from = popLsb(knights);
+            addTargets(moves, from, attacks::knightAttacks(from) & allowed, st.enemies);
+        }
+
+        Bitboard diagonal = (position.getPieces(st.us, BISHOP) | position.getPieces(st.us, QUEEN)) & mask;
+        while (diagonal) {
+            int from = popLsb(diagonal);
+            addTargets(moves, from, attacks::bishopAttacks(from, st.occupied) & allowed & pinMask(st, from), st.enemies);
+        }
+
+        Bitboard straight = (position.getPieces(st.us, ROOK) | position.getPieces(st.us, QUEEN)) & mask;
+        while (straight) {
+            int from = popLsb(straight);
+            addTargets(moves, from, attacks::rookAttacks(from, st.occupied) & allowed & pinMask(st, from), st.enemies);
+        }
+    }
+}
+
+MoveGenState computeMoveGenState(const Position& position) {
+    MoveGenState st;
+    st.us = position.getSideToMove();
+    st.them = Color(st.us ^ 1);
+    st.king = position.getKingSquare(st.us);
+    st.own = position.getPieces(st.us);
+    st.enemies = position.getPieces(st.them);
+    st.occupied = position.getOccupied();
+
+    st.checkers = position.attackersTo(st.king, st.occupied) & st.enemies;
+    st.checkMask = ~0ULL;
+    if (st.checkers) {
+        st.checkMask = st.checkers | attacks::between(st.king, lsb(st.checkers));
+    }
+
+    // Sliders that would see the king through exactly one of our pieces pin it
+    Bitboard straight = position.getPieces(st.them, ROOK) | position.getPieces(st.them, QUEEN);
+    Bitboard diagonal = position.getPieces(st.them, BISHOP) | position.getPieces(st.them, QUEEN);
+    Bitboard pinners = (attacks::rookAttacks(st.king, st.enemies) & straight)
+        | (attacks::bishopAttacks(st.king, st.enemies) & diagonal);
+    st.pinned = 0;
+    while (pinners) {
+        Bitboard blockers = attacks::between(st.king, popLsb(pinners)) & st.occupied;
+        if (popcount(blockers) == 1) {
+            st.pinned |= blockers & st.own;
+        }
+    }
+
+    st.danger = attackedSquares(position, st.them, st.occupied ^ squareBB(st.king));
+    return st;
+}
+
+void generateMoves(const Position& position, MoveList& moves) {
+    moves.clear();
+    generate(position, computeMoveGenState(position), moves, ALL_MOVES, ~0ULL);
+}
+
+void generateMoves(const Position& position, const MoveGenState& state, MoveList& moves, MoveGenType type) {
+    moves.clear();
+    generate(position, state, moves, type, ~0ULL);
+}
+
+// Only the moving piece's moves are generated, a move from anywhere else (a killer or a
+// table move of another position) is usually rejected on the first test
+bool isLegalMove(const Position& position, const MoveGenState& state, Move move) {
+    if (move.isNull() || !(state.own & squareBB(move.getFrom()))) {
+        return false;
+    }
+    MoveList moves;
+    generate(position, state, moves, move.isCapture() || move.isPromotion() ? NOISY_MOVES : QUIET_MOVES, squareBB(move.getFrom()));
+    for (Move candidate : moves) {
+        if (candidate == move) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Move parseUciMove(const Position& position, const std::string& text) {
+    MoveList moves;
+    generateMoves(position, moves);
+    for (const Move& move : moves) {
+        if (move.toString() == text) {
+            return move;
+        }
+    }
+    return Move();
+}
+
+// Standard algebraic notation
+
+namespace {
+    const char SAN_PIECES[] = "PNBRQK";
+
+    int pieceFromSan(char ch) {
+        for (int pt = KNIGHT; pt <= KING; pt++) {
+            if (SAN_PIECES[pt] == ch) {
+                return pt;
+            }
+        }
+        return -1;
+    }
+
+    // Whether a move leaves its king safe, by looking for attackers of the king on the
+    // board as it will be after the move
+    bool leavesKingSafe(const Position& position, Move move) {
+        Color us = position.getSideToMove();
+        int from = move.getFrom();
+        int to = move.getTo();
+        int captured = move.getFlags() == EP_CAPTURE ? (us == WHITE ? to - 8 : to + 8) : to;
+        Bitboard occupied = (position.getOccupied() ^ squareBB(from) ^ squareBB(captured)) | squareBB(to);
+        int king = typeOf(position.pieceOn(from)) == KING ? to : position.getKingSquare(us);
+        return !(position.attackersTo(king, occupied) & position.getPieces(Color(us ^ 1)) & ~squareBB(captured));
+    }
+}
+
+Move parseSan(const Position& position, std::string_view text) {
+    while (!text.empty() && (text.back() == '+' || text.back() == '#' || text.back() == '!' || text.back() == '?')) {
+        text.remove_suffix(1);
+    }
+
+    // Castling, the zero spelling shows up in older databases
+    if (text == "O-O" || text == "0-0" || text == "O-O-O" || text == "0-0-0") {
+        MoveList moves;
+        generateMoves(position, moves);
+        int flags = text.size() == 3 ? KING_CASTLE : QUEEN_CASTLE;
+        for (const Move& move : moves) {
+            if (move.getFlags() == flags) {
+                return move;
+            }
+        }
+        return Move();
+    }
+
+    PieceType pt = PAWN;
+    if (!text.empty() && pieceFromSan(text[0]) > 0) {
+        pt = PieceType(pieceFromSan(text[0]));
+        text.remove_prefix(1);
+    }
+
+    // Promotion piece, with or without the '='
+    int promotion = -1;
+    if (pt == PAWN && !text.empty() && pieceFromSan(text.back()) > PAWN) {
+        promotion = pieceFromSan(text.back());
+        text.remove_suffix(1);
+        if (!text.empty() && text.back() == '=') {
+            text.remove_suffix(1);
+        }
+    }
+
+    if (text.size() < 2) {
+        return Move();
+    }
+    char toFile = text[text.size() - 2];
+    char toRank = text[text.size() - 1];
+    if (toFile < 'a' || toFile > 'h' || toRank < '1' || toRank > '8') {
+        return Move();
+    }
+    int to = makeSquare(toFile - 'a', toRank - '1');
+    text.remove_suffix(2);
+
+    // Whatever is left is disambiguation and capture marks
+    int fromFile = -1;
+    int fromRank = -1;
+    for (char ch : text) {
+        if (ch >= 'a' && ch <= 'h') {
+            fromFile = ch - 'a';
+        }
+        else if (ch >= '1' && ch <= '8') {
+            fromRank = ch - '1';
+        }
+        else if (ch != 'x' && ch != '-' && ch != ':') {
+            return Move();
+        }
+    }
+
+    // Rather than generating every move, the pieces of that type able to reach the square
+    // are looked up and each one checked for legality, replaying games is mostly this
+    Color us = position.getSideToMove();
+    PieceCode target = position.pieceOn(to);
+    if (target != NO_PIECE && colorOf(target) == us) {
+        return Move();
+    }
+    Bitboard occupied = position.getOccupied();
+    Bitboard candidates;
+    switch (pt) {
+    case PAWN: {
+        int relativeRank = us == WHITE ? rankOf(to) : 7 - rankOf(to);
+        if (relativeRank < 2 || (relativeRank == 7) != (promotion >= 0)) {
+            return Move();
+        }
+        int back = us == WHITE ? -8 : 8;
+        if (fromFile >= 0) {
+            // Captures always name the file, the target is a piece or the en-passant square
+            bool takes = target != NO_PIECE || to == position.getEnPassantSquare();
+            candidates = takes ? attacks::pawnAttacks(Color(us ^ 1), to) : 0;
+        }
+        else if (target != NO_PIECE) {
+            candidates = 0;
+        }
+        else if (position.pieceOn(to + back) != NO_PIECE) {
+            candidates = squareBB(to + back);
+        }
+        else {
+            // Double push from the second rank over an empty square
+            bool fromStart = rankOf(to) == (us == WHITE ? 3 : 4);
+            candidates = fromStart ? squareBB(to + 2 * back) : 0;
+        }
+        candidates &= position.getPieces(us, PAWN);
+        break;
+    }
+    case KNIGHT: candidates = attacks::knightAttacks(to); break;
+    case BISHOP: candidates = attacks::bishopAttacks(to, occupied); break;
+    case ROOK: candidates = attacks::rookAttacks(to, occupied); break;
+    case QUEEN: candidates = attacks::queenAttacks(to, occupied); break;
+    default: candidates = attacks::kingAttacks(to); break;
+    }
+    candidates &= position.getPieces(us, pt);
+    if (fromFile >= 0) {
+        candidates &= FILE_A_BB << fromFile;
+    }
+    if (fromRank >= 0) {
+        candidates &= RANK_1_BB << (8 * fromRank);
+    }
+
+    Move found;
+    while (candidates) {
+        int from = popLsb(candidates);
+        int flags = target != NO_PIECE ? CAPTURE : QUIET;
+        if (pt == PAWN && fileOf(from) != fileOf(to) && target == NO_PIECE) {
+            flags = EP_CAPTURE;
+        }
+        else if (pt == PAWN && (to - from == 16 || from - to == 16)) {
+            flags = DOUBLE_PUSH;
+        }
+        if (promotion >= 0) {
+            flags = (flags == CAPTURE ? PROMOTION_CAPTURE : PROMOTION) | (promotion - KNIGHT);
+        }
+
+        Move move(from, to, flags);
+        if (!leavesKingSafe(position, move)) {
+            continue;
+        }
+        if (!found.isNull()) {
+            return Move();
+        }
+        found = move;
+    }
+    return found;
+}
+
+std::string toSan(Position& position, Move move) {
+    int from = move.getFrom();
+    int to = move.getTo();
+    PieceType pt = typeOf(position.pieceOn(from));
+    MoveList moves;
+    generateMoves(position, moves);
+
+    std::string san;
+    if (move.getFlags() == KING_CASTLE || move.getFlags() == QUEEN_CASTLE) {
+        san = move.getFlags() == KING_CASTLE ? "O-O" : "O-O-O";
+    }
+    else {
+        if (pt != PAWN) {
+            san += SAN_PIECES[pt];
+
+            // Name the file, else the rank, else both, of the one piece that can go there
+            bool ambiguous = false;
+            bool sameFile = false;
+            bool sameRank = false;
+            for (const Move& other : moves) {
+                if (other.getTo() == to && other.getFrom() != from && typeOf(position.pieceOn(other.getFrom())) == pt) {
+                    ambiguous = true;
+                    sameFile |= fileOf(other.getFrom()) == fileOf(from);
+                    sameRank |= rankOf(other.getFrom()) == rankOf(from);
+                }
+            }
+            if (ambiguous && (!sameFile || sameRank)) {
+                san += char('a' + fileOf(from));
+            }
+            if (ambiguous && sameFile) {
+                san += char('1' + rankOf(from));
+            }
+        }
+        else if (move.isCapture()) {
+            san += char('a' + fileOf(from));
+        }
+        if (move.isCapture()) {
+            san += 'x';
+        }
+        san += char('a' + fileOf(to));
+        san += char('1' + rankOf(to));
+        if (move.isPromotion()) {
+            san += '=';
+            san += SAN_PIECES[move.getPromotion()];
+        }
+    }
+
+    position.makeMove(move);
+    if (position.isInCheck()) {
+        MoveList replies;
+        generateMoves(position, replies);
+        san += replies.empty() ? '#' : '+';
+    }
+    position.unmakeMove();
+    return san;
+}
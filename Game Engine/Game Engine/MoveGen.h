@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include "Position.h"
+#include "Move.h"
+
+// Noisy moves are captures and promotions, quiet moves all the others
+enum MoveGenType : int {
+    ALL_MOVES,
+    NOISY_MOVES,
+    QUIET_MOVES
+};
+
+// What legality depends on: checks, pins and the squares the enemy attacks. Worked out once
+// per position, so a staged generation can produce its move types without redoing it.
+struct MoveGenState {
+    Color us;
+    Color them;
+    int king;
+    Bitboard own;
+    Bitboard enemies;
+    Bitboard occupied;
+    Bitboard checkers;  // Enemy pieces giving check
+    Bitboard checkMask; // Squares that capture or block a single checker, all squares when not in check
+    Bitboard pinned;    // Our pieces that may only move along the line to their king
+    Bitboard danger;    // Squares attacked by the enemy with our king removed
+};
+
+MoveGenState computeMoveGenState(const Position& position);
+
+// Fills the list with the moves of every piece of the side to move, without touching the heap
+void generateMoves(const Position& position, MoveList& moves);
+// Same for one type of move, the state must be the position's
+void generateMoves(const Position& position, const MoveGenState& state, MoveList& moves, MoveGenType type);
+
+// Whether a move from elsewhere (the transposition table, a killer slot) is legal here
+bool isLegalMove(const Position& position, const MoveGenState& state, Move move);
+
+// Legal move matching a UCI string such as "e2e4" or "e7e8q", null if there is none
+Move parseUciMove(const Position& position, const std::string& text);
+
+// Legal move matching a SAN string such as "Nbd7", "exd5", "O-O" or "e8=Q+". Check marks and
+// annotations are optional, null if no move or more than one move matches.
+Move parseSan(const Position& position, std::string_view text);
+
+// SAN of a legal move. The move is played and taken back to find check and mate, the
+// position is left as it was.
+std::string toSan(Position& position, Move move);
@@ -0,0 +1,228 @@
+#include "MovePicker.h"
+#include <utility>
+#include "Evaluation.h"
+
+namespace {
+    constexpr int TT_MOVE_SCORE = 1 << 30;
+    constexpr int CAPTURE_SCORE = 1 << 20;
+    constexpr int KILLER_SCORE = 1 << 19;
+}
+
+// ======================
+// Static exchange evaluation
+// ======================
+
+bool seeGreaterEqual(const Position& position, Move move, int threshold) {
+    int flags = move.getFlags();
+    if (flags == KING_CASTLE || flags == QUEEN_CASTLE) {
+        return threshold <= 0;
+    }
+
+    int from = move.getFrom();
+    int to = move.getTo();
+    PieceType captured = flags == EP_CAPTURE ? PAWN : move.isCapture() ? typeOf(position.pieceOn(to)) : PIECE_TYPE_NB;
+    int swap = (captured == PIECE_TYPE_NB ? 0 : eval::PIECE_VALUES[captured]) - threshold;
+    if (swap < 0) {
+        return false;
+    }
+    // Even losing the moving piece for nothing keeps the threshold
+    swap = eval::PIECE_VALUES[typeOf(position.pieceOn(from))] - swap;
+    if (swap <= 0) {
+        return true;
+    }
+
+    Bitboard occupied = position.getOccupied() ^ squareBB(from) ^ squareBB(to);
+    if (flags == EP_CAPTURE) {
+        occupied ^= squareBB(to + (position.getSideToMove() == WHITE ? -8 : 8));
+    }
+    Bitboard diagonal = position.getPieces(WHITE, BISHOP) | position.getPieces(BLACK, BISHOP)
+        | position.getPieces(WHITE, QUEEN) | position.getPieces(BLACK, QUEEN);
+    Bitboard straight = position.getPieces(WHITE, ROOK) | position.getPieces(BLACK, ROOK)
+        | position.getPieces(WHITE, QUEEN) | position.getPieces(BLACK, QUEEN);
+    Bitboard attackers = position.attackersTo(to, occupied);
+    Color stm = position.getSideToMove();
+
+    // Sides take turns recapturing with their cheapest attacker, each capture may uncover a
+    // slider behind it. swap is what the side that just captured stands to lose, res flips
+    // with every capture and ends as whether the move's side keeps the threshold.
+    int res = 1;
+    while (true) {
+        stm = Color(stm ^ 1);
+        attackers &= occupied;
+        Bitboard stmAttackers = attackers & position.getPieces(stm);
+        if (!stmAttackers) {
+            break;
+        }
+        res ^= 1;
+
+        PieceType pt = PAWN;
+        while (!(stmAttackers & position.getPieces(stm, pt))) {
+            pt = PieceType(pt + 1);
+        }
+        if (pt == KING) {
+            // The king may only take when nothing guards the square any more
+            return (attackers & ~position.getPieces(stm)) ? res ^ 1 : res;
+        }
+
+        swap = eval::PIECE_VALUES[pt] - swap;
+        if (swap < res) {
+            break;
+        }
+        occupied ^= squareBB(lsb(stmAttackers & position.getPieces(stm, pt)));
+        if (pt == PAWN || pt == BISHOP || pt == QUEEN) {
+            attackers |= attacks::bishopAttacks(to, occupied) & diagonal;
+        }
+        if (pt == ROOK || pt == QUEEN) {
+            attackers |= attacks::rookAttacks(to, occupied) & straight;
+        }
+    }
+    return res;
+}
+
+// ======================
+// MovePicker
+// ======================
+
+MovePicker::MovePicker(const Position& position, Move ttMove, const Move* killers, Move counterMove, const int (*history)[64])
+    : position(position), state(computeMoveGenState(position)), stage(TT_MOVE), quiescence(false), ttMove(ttMove),
+    refutations{ killers[0], killers[1], counterMove }, history(history) {
+}
+
+MovePicker::MovePicker(const Position& position, const MoveList& rootMoves, Move ttMove, const Move* killers, Move counterMove, const int (*history)[64])
+    : MovePicker(position, ttMove, killers, counterMove, history) {
+    this->rootMoves = &rootMoves;
+    stage = GENERATE_ROOT;
+}
+
+MovePicker::MovePicker(const Position& position)
+    : position(position), state(computeMoveGenState(position)), stage(GENERATE_NOISY), quiescence(true), history(nullptr) {
+}
+
+bool MovePicker::isRefutation(Move move) const {
+    return move == refutations[0] || move == refutations[1] || move == refutations[2];
+}
+
+int MovePicker::noisyScore(Move move) const {
+    // The promoted piece counts as won material, a plain promotion captures nothing
+    int gain = move.getFlags() == EP_CAPTURE ? eval::PIECE_VALUES[PAWN]
+        : move.isCapture() ? eval::PIECE_VALUES[typeOf(position.pieceOn(move.getTo()))] : 0;
+    if (move.isPromotion()) {
+        gain += eval::PIECE_VALUES[move.getPromotion()];
+    }
+    PieceType attacker = typeOf(position.pieceOn(move.getFrom()));
+    return CAPTURE_SCORE + gain * 16 - attacker;
+}
+
+Move MovePicker::selectBest() {
+    int best = current;
+    for (int j = current + 1; j < moves.size(); j++) {
+        if (scores[j] > scores[best]) {
+            best = j;
+        }
+    }
+    std::swap(moves[current], moves[best]);
+    std::swap(scores[current], scores[best]);
+    return moves[current++];
+}
+
+Move MovePicker::next() {
+    switch (stage) {
+    case TT_MOVE:
+        stage = GENERATE_NOISY;
+        if (isLegalMove(position, state, ttMove)) {
+            return ttMove;
+        }
+        [[fallthrough]];
+
+    case GENERATE_NOISY:
+        generateMoves(position, state, moves, NOISY_MOVES);
+        for (int i = 0; i < moves.size(); i++) {
+            scores[i] = noisyScore(moves[i]);
+        }
+        current = 0;
+        stage = GOOD_NOISY;
+        [[fallthrough]];
+
+    case GOOD_NOISY:
+        while (current < moves.size()) {
+            Move move = selectBest();
+            if (move == ttMove) {
+                continue;
+            }
+            // Promotions always come early, a capture that loses material waits for the end
+            if (move.isCapture() && !move.isPromotion() && !seeGreaterEqual(position, move, 0)) {
+                badCaptures.add(move);
+                continue;
+            }
+            return move;
+        }
+        // Quiescence has no use for the losing captures
+        stage = quiescence ? DONE : REFUTATIONS;
+        return next();
+
+    case REFUTATIONS:
+        while (refutationIndex < 3) {
+            Move move = refutations[refutationIndex++];
+            // The killers differ from each other, the counter-move may be one of them
+            bool repeated = refutationIndex == 3 && (move == refutations[0] || move == refutations[1]);
+            if (move != ttMove && !repeated && !move.isCapture() && !move.isPromotion() && isLegalMove(position, state, move)) {
+                return move;
+            }
+        }
+        stage = GENERATE_QUIETS;
+        [[fallthrough]];
+
+    case GENERATE_QUIETS:
+        generateMoves(position, state, moves, QUIET_MOVES);
+        for (int i = 0; i < moves.size(); i++) {
+            scores[i] = history[moves[i].getFrom()][moves[i].getTo()];
+        }
+        current = 0;
+        stage = QUIETS;
+        [[fallthrough]];
+
+    case QUIETS:
+        while (current < moves.size()) {
+            Move move = selectBest();
+            if (move != ttMove && !isRefutation(move)) {
+                return move;
+            }
+        }
+        stage = BAD_CAPTURES;
+        [[fallthrough]];
+
+    case BAD_CAPTURES:
+        if (badCurrent < badCaptures.size()) {
+            return badCaptures[badCurrent++];
+        }
+        stage = DONE;
+        return Move();
+
+    case GENERATE_ROOT:
+        // Every root move is scored up front, there are few root nodes
+        moves = *rootMoves;
+        for (int i = 0; i < moves.size(); i++) {
+            Move move = moves[i];
+            scores[i] = move == ttMove ? TT_MOVE_SCORE
+                : move.isCapture() || move.isPromotion() ? noisyScore(move)
+                : move == refutations[0] ? KILLER_SCORE + 2
+                : move == refutations[1] ? KILLER_SCORE + 1
+                : move == refutations[2] ? KILLER_SCORE
+                : history[move.getFrom()][move.getTo()];
+        }
+        current = 0;
+        stage = ROOT_MOVES;
+        [[fallthrough]];
+
+    case ROOT_MOVES:
+        if (current < moves.size()) {
+            return selectBest();
+        }
+        stage = DONE;
+        return Move();
+
+    case DONE:
+        break;
+    }
+    return Move();
+}
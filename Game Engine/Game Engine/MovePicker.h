@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Position.h"
+#include "MoveGen.h"
+
+// Static exchange evaluation: whether the exchanges started by the move on its target square
+// gain at least the threshold in centipawns, each side recapturing with its cheapest piece
+// or standing pat when that is better. Pins are not looked at.
+bool seeGreaterEqual(const Position& position, Move move, int threshold);
+
+// Hands out the moves of a node one at a time, most promising first, and only generates a
+// stage once the ones before it failed to cut off: the transposition table move (checked
+// for legality, nothing generated yet), captures and promotions that do not lose material
+// ordered by MVV-LVA, the two killers and the counter-move, the quiet moves by history,
+// then the captures that lose material. Killers and counter-moves come from other
+// positions and are checked for legality too.
+
+class MovePicker {
+    enum Stage : int {
+        TT_MOVE,
+        GENERATE_NOISY,
+        GOOD_NOISY,
+        REFUTATIONS,
+        GENERATE_QUIETS,
+        QUIETS,
+        BAD_CAPTURES,
+        GENERATE_ROOT,
+        ROOT_MOVES,
+        DONE
+    };
+
+    const Position& position;
+    MoveGenState state;
+    Stage stage;
+    bool quiescence; // Only the noisy moves that do not lose material
+    Move ttMove;
+    Move refutations[3]; // Killers then the counter-move
+    int refutationIndex = 0;
+    const int (*history)[64]; // Quiet move history of the side to move, by from and to square
+    const MoveList* rootMoves = nullptr;
+
+    MoveList moves;
+    int scores[MAX_MOVES];
+    int current = 0;
+    MoveList badCaptures;
+    int badCurrent = 0;
+
+    bool isRefutation(Move move) const;
+    // MVV-LVA, the promoted piece counted as captured
+    int noisyScore(Move move) const;
+    // Swaps the best scored remaining move to the current index and returns it
+    Move selectBest();
+public:
+    // Main search. killers holds two moves, history is indexed by the side to move.
+    MovePicker(const Position& position, Move ttMove, const Move* killers, Move counterMove, const int (*history)[64]);
+    // Root, only the given moves are handed out, ordered like the stages would order them
+    MovePicker(const Position& position, const MoveList& rootMoves, Move ttMove, const Move* killers, Move counterMove, const int (*history)[64]);
+    // Quiescence outside of check: promotions and the captures that do not lose material
+    MovePicker(const Position& position);
+
+    // Next move, null once every move was handed out
+    Move next();
+};
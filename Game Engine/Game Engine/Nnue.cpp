@@ -0,0 +1,243 @@
+#include "Nnue.h"
+#include <algorithm>
+#include <cstring>
+#include "MappedFile.h"
+#include "Position.h"
+
+namespace nnue {
+    bool active = false;
+
+    namespace {
+        struct Header {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t inputs;
+            uint32_t half;
+            uint32_t hidden1;
+            uint32_t hidden2;
+            uint32_t padding[2];
+        };
+
+        // Pointers into the mapped file
+        struct Network {
+            const int16_t* ftBiases;
+            const int16_t* ftWeights;
+            const int32_t* l1Biases;
+            const int8_t* l1Weights;
+            const int32_t* l2Biases;
+            const int8_t* l2Weights;
+            const int32_t* outBias;
+            const int8_t* outWeights;
+        };
+
+        constexpr size_t NETWORK_SIZE = sizeof(Header)
+            + NNUE_HALF * sizeof(int16_t) + size_t(NNUE_INPUTS) * NNUE_HALF * sizeof(int16_t)
+            + NNUE_HIDDEN * sizeof(int32_t) + NNUE_HIDDEN * 2 * NNUE_HALF
+            + NNUE_HIDDEN * sizeof(int32_t) + NNUE_HIDDEN * NNUE_HIDDEN
+            + sizeof(int32_t) + NNUE_HIDDEN;
+
+        MappedFile file;
+        Network network;
+        std::string networkPath;
+        bool enabled = true;
+        uint32_t generation = 0;
+
+        template <typename T>
+        const T* take(const uint8_t*& cursor, size_t count) {
+            const T* section = reinterpret_cast<const T*>(cursor);
+            cursor += count * sizeof(T);
+            return section;
+        }
+
+        // Kernels. Every AVX2 kernel has a scalar twin computing exactly the same integers,
+        // the int16 pair sums of maddubs cannot saturate with inputs clipped to 127.
+
+#if defined(USE_AVX2)
+        void transform(const Accumulator& accumulator, Color us, uint8_t* output) {
+            const __m256i zero = _mm256_setzero_si256();
+            for (int side = 0; side < COLOR_NB; side++) {
+                const int16_t* values = accumulator.values[side == 0 ? us : us ^ 1];
+                for (int i = 0; i < NNUE_HALF; i += 32) {
+                    __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(values + i));
+                    __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i*>(values + i + 16));
+                    // packs saturates to [-128, 127] per 128 bit lane, the permute restores the order
+                    __m256i packed = _mm256_max_epi8(_mm256_packs_epi16(a, b), zero);
+                    packed = _mm256_permute4x64_epi64(packed, 0xD8);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + side * NNUE_HALF + i), packed);
+                }
+            }
+        }
+
+        int32_t dot(const uint8_t* input, const int8_t* weights, int count) {
+            const __m256i ones = _mm256_set1_epi16(1);
+            __m256i sum = _mm256_setzero_si256();
+            for (int i = 0; i < count; i += 32) {
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+                __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+                sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(x, w), ones));
+            }
+            __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+            half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+            half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+            return _mm_cvtsi128_si32(half);
+        }
+
+        void updateSide(int16_t* values, const int* added, int addedCount, const int* removed, int removedCount) {
+            for (int i = 0; i < NNUE_HALF; i += 16) {
+                __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i*>(values + i));
+                for (int r = 0; r < removedCount; r++) {
+                    const int16_t* column = network.ftWeights + size_t(removed[r]) * NNUE_HALF + i;
+                    v = _mm256_sub_epi16(v, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column)));
+                }
+                for (int a = 0; a < addedCount; a++) {
+                    const int16_t* column = network.ftWeights + size_t(added[a]) * NNUE_HALF + i;
+                    v = _mm256_add_epi16(v, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column)));
+                }
+                _mm256_store_si256(reinterpret_cast<__m256i*>(values + i), v);
+            }
+        }
+#else
+        void transform(const Accumulator& accumulator, Color us, uint8_t* output) {
+            for (int side = 0; side < COLOR_NB; side++) {
+                const int16_t* values = accumulator.values[side == 0 ? us : us ^ 1];
+                for (int i = 0; i < NNUE_HALF; i++) {
+                    output[side * NNUE_HALF + i] = uint8_t(std::clamp<int>(values[i], 0, 127));
+                }
+            }
+        }
+
+        int32_t dot(const uint8_t* input, const int8_t* weights, int count) {
+            int32_t sum = 0;
+            for (int i = 0; i < count; i++) {
+                sum += int32_t(input[i]) * weights[i];
+            }
+            return sum;
+        }
+
+        void updateSide(int16_t* values, const int* added, int addedCount, const int* removed, int removedCount) {
+            for (int r = 0; r < removedCount; r++) {
+                const int16_t* column = network.ftWeights + size_t(removed[r]) * NNUE_HALF;
+                for (int i = 0; i < NNUE_HALF; i++) {
+                    values[i] -= column[i];
+                }
+            }
+            for (int a = 0; a < addedCount; a++) {
+                const int16_t* column = network.ftWeights + size_t(added[a]) * NNUE_HALF;
+                for (int i = 0; i < NNUE_HALF; i++) {
+                    values[i] += column[i];
+                }
+            }
+        }
+#endif
+
+        // Dense layer followed by the clipped ReLU
+        void affine(const uint8_t* input, int inputCount, const int32_t* biases, const int8_t* weights, uint8_t* output) {
+            for (int o = 0; o < NNUE_HIDDEN; o++) {
+                int32_t sum = biases[o] + dot(input, weights + o * inputCount, inputCount);
+                output[o] = uint8_t(std::clamp(sum >> NNUE_WEIGHT_SHIFT, 0, 127));
+            }
+        }
+    }
+
+    // Loading
+
+    bool load(const std::string& path) {
+        MappedFile candidate;
+        if (!candidate.open(path) || candidate.size() != NETWORK_SIZE) {
+            return false;
+        }
+        Header header;
+        std::memcpy(&header, candidate.data(), sizeof(header));
+        if (header.magic != NNUE_MAGIC || header.version != NNUE_VERSION || header.inputs != NNUE_INPUTS
+            || header.half != NNUE_HALF || header.hidden1 != NNUE_HIDDEN || header.hidden2 != NNUE_HIDDEN) {
+            return false;
+        }
+
+        file = std::move(candidate);
+        const uint8_t* cursor = file.data() + sizeof(Header);
+        network.ftBiases = take<int16_t>(cursor, NNUE_HALF);
+        network.ftWeights = take<int16_t>(cursor, size_t(NNUE_INPUTS) * NNUE_HALF);
+        network.l1Biases = take<int32_t>(cursor, NNUE_HIDDEN);
+        network.l1Weights = take<int8_t>(cursor, NNUE_HIDDEN * 2 * NNUE_HALF);
+        network.l2Biases = take<int32_t>(cursor, NNUE_HIDDEN);
+        network.l2Weights = take<int8_t>(cursor, NNUE_HIDDEN * NNUE_HIDDEN);
+        network.outBias = take<int32_t>(cursor, 1);
+        network.outWeights = take<int8_t>(cursor, NNUE_HIDDEN);
+        networkPath = path;
+        generation++;
+        active = enabled;
+        return true;
+    }
+
+    void unload() {
+        file.close();
+        networkPath.clear();
+        generation++;
+        active = false;
+    }
+
+    bool isLoaded() {
+        return file.isOpen();
+    }
+
+    const std::string& getPath() {
+        return networkPath;
+    }
+
+    void setEnabled(bool value) {
+        enabled = value;
+        active = enabled && file.isOpen();
+    }
+
+    uint32_t getGeneration() {
+        return generation;
+    }
+
+    const char* getSimdName() {
+#if defined(USE_AVX2)
+        return "AVX2";
+#else
+        return "scalar";
+#endif
+    }
+
+    // Accumulator
+
+    void refresh(const Position& position, Accumulator& accumulator, Color perspective) {
+        int indices[32];
+        int count = 0;
+        int king = position.getKingSquare(perspective);
+        Bitboard pieces = position.getOccupied() & ~(position.getPieces(WHITE, KING) | position.getPieces(BLACK, KING));
+        while (pieces) {
+            int sq = popLsb(pieces);
+            indices[count++] = featureIndex(perspective, king, position.pieceOn(sq), sq);
+        }
+        std::memcpy(accumulator.values[perspective], network.ftBiases, sizeof(accumulator.values[perspective]));
+        updateSide(accumulator.values[perspective], indices, count, nullptr, 0);
+    }
+
+    void update(Accumulator& accumulator, Color perspective, const int* added, int addedCount, const int* removed, int removedCount) {
+        updateSide(accumulator.values[perspective], added, addedCount, removed, removedCount);
+    }
+
+    // Forward pass
+
+    int evaluate(const Position& position) {
+        const Accumulator* accumulator = &position.getAccumulator();
+        Accumulator scratch;
+        if (accumulator->generation != generation) {
+            refresh(position, scratch, WHITE);
+            refresh(position, scratch, BLACK);
+            accumulator = &scratch;
+        }
+
+        alignas(32) uint8_t input[2 * NNUE_HALF];
+        alignas(32) uint8_t hidden1[NNUE_HIDDEN];
+        alignas(32) uint8_t hidden2[NNUE_HIDDEN];
+        transform(*accumulator, position.getSideToMove(), input);
+        affine(input, 2 * NNUE_HALF, network.l1Biases, network.l1Weights, hidden1);
+        affine(hidden1, NNUE_HIDDEN, network.l2Biases, network.l2Weights, hidden2);
+        int32_t output = network.outBias[0] + dot(hidden2, network.outWeights, NNUE_HIDDEN);
+        return output / NNUE_OUTPUT_SCALE;
+    }
+}
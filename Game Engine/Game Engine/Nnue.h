@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "Bitboard.h"
+
+#if defined(USE_AVX2)
+#include <immintrin.h>
+#endif
+
+// ======================
+// Efficiently updatable neural network evaluation
+// ======================
+// HalfKP inputs: for each side, every non-king piece is one feature relative to that side's
+// own king square, 64 king squares x (10 piece kinds x 64 squares + 1) inputs. The first
+// layer is kept as a per-side accumulator that a move only adds to or subtracts from,
+// followed by two small int8 layers and an output neuron.
+//
+// Network file, little endian: a 32 byte header (magic, version, input count, accumulator
+// width, the two hidden layer widths as uint32, zero padded), the feature transformer biases
+// and weights (int16, one row of NNUE_HALF per input), then for each of the three dense
+// layers its biases (int32) and weights (int8, one row of inputs per output). The header
+// size keeps every section 32 byte aligned in the mapping, the weights are used in place.
+
+#define NNUE_MAGIC 0x454E4E47 // "GNNE"
+#define NNUE_VERSION 1
+#define NNUE_KING_BUCKET 641
+#define NNUE_INPUTS (64 * NNUE_KING_BUCKET)
+#define NNUE_HALF 256 // Accumulator width per side
+#define NNUE_HIDDEN 32
+#define NNUE_WEIGHT_SHIFT 6 // Fixed point scale of the dense layer weights
+#define NNUE_OUTPUT_SCALE 16 // Output units per centipawn
+
+class Position;
+
+// First layer output for both sides. The generation ties the values to the network they
+// were computed with, anything else means they have to be rebuilt from the board.
+struct Accumulator {
+    alignas(32) int16_t values[COLOR_NB][NNUE_HALF];
+    uint32_t generation = 0;
+};
+
+namespace nnue {
+
+    // Maps and validates a network file, the previous network stays if it fails.
+    // Must not be called while a search is running.
+    bool load(const std::string& path);
+    void unload();
+    bool isLoaded();
+    const std::string& getPath();
+
+    // Runtime switch between the network and the classical evaluation, only takes
+    // effect with a network loaded
+    void setEnabled(bool value);
+
+    // Enabled and loaded, read on every move so it is kept as a plain flag
+    extern bool active;
+
+    inline bool isEnabled() {
+        return active;
+    }
+
+    // Changes every time a network is loaded, accumulators of another generation are stale
+    uint32_t getGeneration();
+
+    // Name of the kernels compiled in
+    const char* getSimdName();
+
+    // Input index of a piece seen from a side with its king on kingSquare
+    inline int featureIndex(Color perspective, int kingSquare, PieceCode pc, int sq) {
+        int orient = perspective == WHITE ? 0 : 56;
+        int kind = 2 * typeOf(pc) + (colorOf(pc) != perspective);
+        return (kingSquare ^ orient) * NNUE_KING_BUCKET + 1 + kind * 64 + (sq ^ orient);
+    }
+
+    // Rebuilds one side of the accumulator from the pieces on the board
+    void refresh(const Position& position, Accumulator& accumulator, Color perspective);
+
+    // Adds and subtracts feature columns in one pass over one side
+    void update(Accumulator& accumulator, Color perspective, const int* added, int addedCount, const int* removed, int removedCount);
+
+    // Score in centipawns from the side to move's point of view, uses the position's
+    // accumulator when it is current and builds a temporary one otherwise
+    int evaluate(const Position& position);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+#include "Position.h"
+
+#define BOOK_ENTRY_SIZE 16 // Bytes per Polyglot entry: key, move, weight and learn field
+
+// One book move with its weight as stored in the file
+struct BookMove {
+    Move move;
+    int weight;
+};
+
+// Polyglot .bin opening book. The file is memory-mapped and never read whole: entries are
+// sorted by key, so a probe is a binary search touching a handful of pages, which the OS
+// shares with every other process that maps the same book.
+
+class OpeningBook {
+    MappedFile file;
+    std::string path;
+    size_t entryCount = 0;
+
+    // Index of the first entry with this key or a larger one
+    size_t lowerBound(uint64_t key) const;
+    // Fields of an entry
+    uint64_t keyAt(size_t index) const;
+    uint16_t moveAt(size_t index) const;
+    int weightAt(size_t index) const;
+public:
+    // Maps a book, false and closed if the file cannot be opened or is not a whole number of entries
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return file.isOpen(); }
+    const std::string& getPath() const { return path; }
+    size_t getEntryCount() const { return entryCount; }
+
+    // Every legal book move of the position in file order, best weight first
+    void probe(const Position& position, std::vector<BookMove>& moves) const;
+    // Book move chosen with probability proportional to its weight, random is any uniform
+    // 64 bit number. Null when the position is not in the book.
+    Move pick(const Position& position, uint64_t random) const;
+};
+
+namespace polyglot {
+
+    // Position key as defined by the Polyglot format, unrelated to the engine's own Zobrist key.
+    // The en passant file only counts when a pawn of the side to move can make the capture.
+    uint64_t key(const Position& position);
+}
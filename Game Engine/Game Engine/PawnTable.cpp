@@ -0,0 +1,41 @@
+#include "PawnTable.h"
+
+// Constructor
+
+PawnTable::PawnTable() : entries(PAWN_TABLE_ENTRIES), probes(0), hits(0) {
+    clear();
+}
+
+// Lookup, always replaces: the newest pawn configuration is the likeliest to come back
+
+PawnEntry& PawnTable::probe(uint64_t key, bool& found) {
+    PawnEntry& entry = entries[key & (PAWN_TABLE_ENTRIES - 1)];
+    probes++;
+    found = entry.key == key;
+    if (found) {
+        hits++;
+    }
+    return entry;
+}
+
+void PawnTable::clear() {
+    for (PawnEntry& entry : entries) {
+        entry = PawnEntry();
+        // Key 0 would match the empty pawn structure, mark the slot unusable instead
+        entry.key = ~0ULL;
+    }
+}
+
+// Statistics
+
+uint64_t PawnTable::getProbes() const {
+    return probes;
+}
+
+uint64_t PawnTable::getHits() const {
+    return hits;
+}
+
+void PawnTable::resetStats() {
+    probes = hits = 0;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Bitboard.h"
+#include "Psqt.h"
+
+#define PAWN_TABLE_ENTRIES 16384 // Power of two
+
+// Pawn structure of one pawn configuration, everything in it depends on the pawns alone
+// except the shelter, which also depends on the king and is redone when the king moves
+struct PawnEntry {
+    uint64_t key;
+    Score score; // Doubled, isolated, backward and passed pawns, white relative
+    Bitboard passed[COLOR_NB];
+    int kingSquare[COLOR_NB]; // Square the shelter was computed for
+    Score shelter[COLOR_NB];
+};
+
+// Cache of pawn structure evaluations keyed by the pawn-only Zobrist key. Sibling nodes
+// almost always share their pawns, so most probes hit. Each search thread owns its own
+// table, nothing is shared and nothing needs locking.
+
+class PawnTable {
+    std::vector<PawnEntry> entries;
+    uint64_t probes;
+    uint64_t hits;
+public:
+    PawnTable();
+
+    // Entry for the key, found tells whether it already holds that key's data
+    PawnEntry& probe(uint64_t key, bool& found);
+    void clear();
+
+    uint64_t getProbes() const;
+    uint64_t getHits() const;
+    void resetStats();
+};
@@ -0,0 +1,47 @@
+#include "Perft.h"
+
+namespace perft {
+    // Reference counts from the Chess Programming Wiki perft results page
+    const std::vector<PerftCase> suite = {
+        { "startpos", START_FEN,
+            { 20, 400, 8902, 197281, 4865609, 119060324 } },
+        { "kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+            { 48, 2039, 97862, 4085603, 193690690, 8031647685ULL } },
+        { "position3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+            { 14, 191, 2812, 43238, 674624, 11030083 } },
+        { "position4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+            { 6, 264, 9467, 422333, 15833292, 706045033 } },
+        { "position5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+            { 44, 1486, 62379, 2103487, 89941194, 0 } },
+        { "position6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+            { 46, 2079, 89890, 3894594, 164075551, 6923051137ULL } },
+    };
+
+    uint64_t perft(Position& position, int depth) {
+        MoveList moves;
+        generateMoves(position, moves);
+        if (depth <= 1) {
+            return depth == 1 ? moves.size() : 1;
+        }
+
+        uint64_t nodes = 0;
+        for (const Move& move : moves) {
+            position.makeMove(move);
+            nodes += perft(position, depth - 1);
+            position.unmakeMove();
+        }
+        return nodes;
+    }
+
+    std::vector<std::pair<Move, uint64_t>> divide(Position& position, int depth) {
+        std::vector<std::pair<Move, uint64_t>> result;
+        MoveList moves;
+        generateMoves(position, moves);
+        for (const Move& move : moves) {
+            position.makeMove(move);
+            result.emplace_back(move, perft(position, depth - 1));
+            position.unmakeMove();
+        }
+        return result;
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include "Position.h"
+#include "MoveGen.h"
+
+#define PERFT_SUITE_MAX_DEPTH 6
+
+// A perft position with its known node counts, expected[d - 1] holds depth d (0 when unknown)
+struct PerftCase {
+    const char* name;
+    const char* fen;
+    uint64_t expected[PERFT_SUITE_MAX_DEPTH];
+};
+
+namespace perft {
+    extern const std::vector<PerftCase> suite;
+
+    // Counts the leaf nodes of the legal move tree, bulk counting at the last ply
+    // The position is walked with make/unmake and is left as it was given
+    uint64_t perft(Position& position, int depth);
+
+    // Node counts below each root move
+    std::vector<std::pair<Move, uint64_t>> divide(Position& position, int depth);
+}
@@ -0,0 +1,114 @@
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include "Attacks.h"
+#include "Perft.h"
+
+// Headless perft runner
+//   perft                          runs the built-in suite up to depth 5
+//   perft --depth N                runs the suite up to depth N
+//   perft --fen "<fen>" --depth N  counts a single position
+//   --divide                       also prints the node count below each root move
+
+namespace {
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void printUsage() {
+        std::cout << "Usage: perft [--depth N] [--fen \"<fen>\"] [--divide]" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int depth = 5;
+    std::string fen;
+    bool divide = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--depth") && i + 1 < argc) {
+            depth = std::stoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--fen") && i + 1 < argc) {
+            fen = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--divide")) {
+            divide = true;
+        }
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (depth < 1) {
+        printUsage();
+        return 1;
+    }
+
+    attacks::init();
+
+    std::vector<PerftCase> cases;
+    if (fen.empty()) {
+        cases = perft::suite;
+    }
+    else {
+        cases.push_back({ "custom", fen.c_str(), {} });
+    }
+
+    int failures = 0;
+    uint64_t totalNodes = 0;
+    double totalTime = 0;
+
+    for (const PerftCase& c : cases) {
+        Position position;
+        if (!position.setFen(c.fen)) {
+            std::cout << c.name << ": invalid FEN " << c.fen << std::endl;
+            return 1;
+        }
+        std::cout << c.name << "  " << c.fen << std::endl;
+
+        if (divide) {
+            auto start = std::chrono::steady_clock::now();
+            uint64_t nodes = 0;
+            for (const auto& [move, count] : perft::divide(position, depth)) {
+                std::cout << "  " << move.toString() << ": " << count << std::endl;
+                nodes += count;
+            }
+            std::cout << "  divide total " << nodes << " in " << std::fixed << std::setprecision(3) << secondsSince(start) << "s" << std::endl;
+        }
+
+        for (int d = 1; d <= depth; d++) {
+            // The suite only runs as deep as it has reference counts
+            uint64_t expected = d <= PERFT_SUITE_MAX_DEPTH ? c.expected[d - 1] : 0;
+            if (fen.empty() && expected == 0) {
+                break;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            uint64_t nodes = perft::perft(position, d);
+            double elapsed = secondsSince(start);
+            totalNodes += nodes;
+            totalTime += elapsed;
+
+            std::cout << "  depth " << d << "  nodes " << std::setw(12) << nodes
+                << "  time " << std::fixed << std::setprecision(3) << elapsed << "s"
+                << "  nps " << std::setw(12) << uint64_t(elapsed > 0 ? nodes / elapsed : 0);
+            if (expected) {
+                bool ok = nodes == expected;
+                failures += !ok;
+                std::cout << (ok ? "  OK" : "  FAIL expected " + std::to_string(expected));
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    std::cout << "total nodes " << totalNodes << "  time " << std::fixed << std::setprecision(3) << totalTime
+        << "s  nps " << uint64_t(totalTime > 0 ? totalNodes / totalTime : 0) << std::endl;
+    if (failures) {
+        std::cout << failures << " perft count(s) did not match" << std::endl;
+        return 1;
+    }
+    return 0;
+}
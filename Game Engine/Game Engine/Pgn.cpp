@@ -0,0 +1,253 @@
+#include "Pgn.h"
+#include <algorithm>
+#include "MoveGen.h"
+
+// Game
+
+std::string_view PgnGame::getTag(std::string_view name) const {
+    for (const auto& tag : tags) {
+        if (tag.first == name) {
+            return tag.second;
+        }
+    }
+    return std::string_view();
+}
+
+void PgnGame::clear() {
+    tags.clear();
+    moves.clear();
+    result = std::string_view();
+}
+
+// Reader
+
+namespace {
+    bool isSpace(char ch) {
+        return ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t';
+    }
+
+    bool isResult(std::string_view token) {
+        return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+    }
+
+    // Characters that end a SAN token besides white space
+    bool endsToken(char ch) {
+        return isSpace(ch) || ch == '{' || ch == '(' || ch == ')' || ch == ';' || ch == '$' || ch == '[';
+    }
+}
+
+bool PgnReader::open(const std::string& path) {
+    if (!file.open(path)) {
+        return false;
+    }
+    cursor = reinterpret_cast<const char*>(file.data());
+    end = cursor + file.size();
+    gamesRead = 0;
+    return true;
+}
+
+void PgnReader::openBuffer(std::string_view text) {
+    file.close();
+    cursor = text.data();
+    end = cursor + text.size();
+    gamesRead = 0;
+}
+
+// Skips a parenthesized variation, nested ones and comments inside included
+void PgnReader::skipVariation() {
+    int depth = 0;
+    while (cursor < end) {
+        char ch = *cursor++;
+        if (ch == '(') {
+            depth++;
+        }
+        else if (ch == ')' && --depth == 0) {
+            return;
+        }
+        else if (ch == '{') {
+            while (cursor < end && *cursor != '}') {
+                cursor++;
+            }
+            cursor += cursor < end;
+        }
+    }
+}
+
+bool PgnReader::next(PgnGame& game) {
+    game.clear();
+    bool inMoves = false;
+    bool lineStart = true;
+
+    while (cursor < end) {
+        char ch = *cursor;
+        if (isSpace(ch)) {
+            lineStart = ch == '\n';
+            cursor++;
+            continue;
+        }
+
+        // Escape lines and rest of line comments
+        if ((ch == '%' && lineStart) || ch == ';') {
+            while (cursor < end && *cursor != '\n') {
+                cursor++;
+            }
+            continue;
+        }
+        lineStart = false;
+
+        if (ch == '[') {
+            // Tags after movetext belong to the next game, whose result was left out
+            if (inMoves) {
+                break;
+            }
+            const char* p = cursor + 1;
+            while (p < end && isSpace(*p)) p++;
+            const char* nameStart = p;
+            while (p < end && !isSpace(*p) && *p != '"' && *p != ']') p++;
+            std::string_view name(nameStart, size_t(p - nameStart));
+            while (p < end && *p != '"' && *p != ']') p++;
+            std::string_view value;
+            if (p < end && *p == '"') {
+                const char* valueStart = ++p;
+                while (p < end && *p != '"') {
+                    p += (*p == '\\' && p + 1 < end) ? 2 : 1;
+                }
+                value = std::string_view(valueStart, size_t(std::min(p, end) - valueStart));
+            }
+            while (p < end && *p != ']') p++;
+            cursor = p + (p < end);
+            game.tags.emplace_back(name, value);
+            continue;
+        }
+
+        if (ch == '{') {
+            while (cursor < end && *cursor != '}') {
+                cursor++;
+            }
+            cursor += cursor < end;
+            continue;
+        }
+        if (ch == '(') {
+            skipVariation();
+            continue;
+        }
+        if (ch == ')') {
+            cursor++;
+            continue;
+        }
+        if (ch == '$') {
+            cursor++;
+            while (cursor < end && *cursor >= '0' && *cursor <= '9') {
+                cursor++;
+            }
+            continue;
+        }
+
+        // Move number, result or move
+        inMoves = true;
+        const char* start = cursor;
+        while (cursor < end && !endsToken(*cursor)) {
+            cursor++;
+        }
+        std::string_view token(start, size_t(cursor - start));
+        if (isResult(token)) {
+            game.result = token;
+            break;
+        }
+        if (ch >= '1' && ch <= '9') {
+            // "12." or "12..." possibly glued to its move as in "12.Nf3"
+            size_t dots = token.find_first_not_of("0123456789");
+            if (dots == std::string_view::npos) {
+                continue;
+            }
+            token.remove_prefix(dots);
+            while (!token.empty() && token.front() == '.') {
+                token.remove_prefix(1);
+            }
+            if (token.empty()) {
+                continue;
+            }
+        }
+        game.moves.push_back(token);
+    }
+
+    if (game.tags.empty() && game.moves.empty() && game.result.empty()) {
+        return false;
+    }
+    gamesRead++;
+    return true;
+}
+
+// Replay and export
+
+namespace pgn {
+
+    bool replay(const PgnGame& game, Position& position, const std::function<void(const Position&, Move)>& onMove) {
+        std::string_view fen = game.getTag("FEN");
+        if (!position.setFen(fen.empty() ? START_FEN : std::string(fen))) {
+            return false;
+        }
+        for (std::string_view san : game.moves) {
+            Move move = parseSan(position, san);
+            if (move.isNull()) {
+                return false;
+            }
+            if (onMove) {
+                onMove(position, move);
+            }
+            position.makeMove(move);
+        }
+        return true;
+    }
+
+    std::string write(const std::vector<std::pair<std::string, std::string>>& tags, const std::string& startFen,
+        const std::vector<Move>& moves, const std::string& result) {
+        std::string text;
+        for (const auto& tag : tags) {
+            text += "[" + tag.first + " \"";
+            for (char ch : tag.second) {
+                if (ch == '"' || ch == '\\') {
+                    text += '\\';
+                }
+                text += ch;
+            }
+            text += "\"]\n";
+        }
+
+        Position position;
+        std::string fen = startFen.empty() ? START_FEN : startFen;
+        position.setFen(fen);
+        if (fen != START_FEN) {
+            text += "[SetUp \"1\"]\n[FEN \"" + fen + "\"]\n";
+        }
+        text += '\n';
+
+        // Tokens are joined with spaces, a token that would pass the limit starts a new line
+        size_t lineLength = 0;
+        auto emit = [&](const std::string& token) {
+            if (lineLength && lineLength + 1 + token.size() > PGN_LINE_WIDTH) {
+                text += '\n';
+                lineLength = 0;
+            }
+            if (lineLength) {
+                text += ' ';
+                lineLength++;
+            }
+            text += token;
+            lineLength += token.size();
+        };
+
+        for (size_t i = 0; i < moves.size(); i++) {
+            if (position.getSideToMove() == WHITE) {
+                emit(std::to_string(position.getFullmoveNumber()) + ".");
+            }
+            else if (i == 0) {
+                emit(std::to_string(position.getFullmoveNumber()) + "...");
+            }
+            emit(toSan(position, moves[i]));
+            position.makeMove(moves[i]);
+        }
+        emit(result);
+        return text + "\n\n";
+    }
+}
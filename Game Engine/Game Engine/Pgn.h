@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "MappedFile.h"
+#include "Position.h"
+
+#define PGN_LINE_WIDTH 80 // Export format line limit
+
+// One game as read from a PGN file. Every view points into the reader's input, so a game is
+// only valid until the next call to next(). Tag values are kept as written, escapes included.
+struct PgnGame {
+    std::vector<std::pair<std::string_view, std::string_view>> tags;
+    std::vector<std::string_view> moves; // SAN tokens of the main line, numbers and comments dropped
+    std::string_view result;
+
+    // Value of a tag, empty if the game does not have it
+    std::string_view getTag(std::string_view name) const;
+    // Keeps the capacity, reading a database allocates only for the longest game
+    void clear();
+};
+
+// Streaming PGN tokenizer over a memory-mapped file. Games are cut straight out of the
+// mapping, comments, NAGs, escapes and variations are skipped without copying anything.
+
+class PgnReader {
+    MappedFile file;
+    const char* cursor = nullptr;
+    const char* end = nullptr;
+    uint64_t gamesRead = 0;
+
+    void skipVariation();
+public:
+    // Maps a PGN file, false if it cannot be opened
+    bool open(const std::string& path);
+    // Reads from text owned by the caller, which must outlive the reader's games
+    void openBuffer(std::string_view text);
+
+    // Reads the next game, false once the input is exhausted
+    bool next(PgnGame& game);
+
+    uint64_t getGamesRead() const { return gamesRead; }
+};
+
+namespace pgn {
+
+    // Sets up the game's start, its FEN tag or the initial position, then plays its moves.
+    // The callback sees each move with the position it is played from. Returns false at the
+    // first move that does not resolve to exactly one legal move.
+    bool replay(const PgnGame& game, Position& position, const std::function<void(const Position&, Move)>& onMove = nullptr);
+
+    // Export format: tags in the given order, then the movetext wrapped at PGN_LINE_WIDTH.
+    // A start position other than the initial one gets SetUp and FEN tags.
+    std::string write(const std::vector<std::pair<std::string, std::string>>& tags, const std::string& startFen,
+        const std::vector<Move>& moves, const std::string& result);
+}
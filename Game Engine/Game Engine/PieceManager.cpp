@@ -5,45 +5,38 @@ PieceManager* PieceManager::instance = nullptr;
 // Constructor and Deconstructor
 
 PieceManager::PieceManager() {
-    // Initialize board to easily handle empty ptrs
-    for (int x = 0; x < 8; x++) {
-        for (int y = 0; y < 8; y++) {
-            board[x][y] = nullptr;
-        }
-    }
+    attacks::init();
+    position.setFen(START_FEN);
+    createSprites();
+    rebuildHitMasks();
+}
 
-    // Initialize pawns
-    for (int i = 0; i < 8; i++) {
-        board[i][6] = new Pawn(true, i, 6);
-        board[i][1] = new Pawn(false, i, 1);
+PieceManager::~PieceManager() {
+    for (int sq = 0; sq < 64; sq++) {
+        delete sprites[sq];
     }
+}
 
-    // White pieces
-    board[0][7] = new Rook(true, 0, 7);
-    board[7][7] = new Rook(true, 7, 7);
-    board[1][7] = new Knight(true, 1, 7);
-    board[6][7] = new Knight(true, 6, 7);
-    board[2][7] = new Bishop(true, 2, 7);
-    board[5][7] = new Bishop(true, 5, 7);
-    board[3][7] = new Queen(true, 3, 7);
-    board[4][7] = new King(true, 4, 7);
-
-    // Black pieces
-    board[0][0] = new Rook(false, 0, 0);
-    board[7][0] = new Rook(false, 7, 0);
-    board[1][0] = new Knight(false, 1, 0);
-    board[6][0] = new Knight(false, 6, 0);
-    board[2][0] = new Bishop(false, 2, 0);
-    board[5][0] = new Bishop(false, 5, 0);
-    board[3][0] = new Queen(false, 3, 0);
-    board[4][0] = new King(false, 4, 0);
+// Sprite creation, mirrors whatever the position holds
+
+Piece* PieceManager::createPiece(PieceCode pc, int sq) const {
+    bool isWhite = colorOf(pc) == WHITE;
+    int x = cordsX(sq);
+    int y = cordsY(sq);
+    switch (typeOf(pc)) {
+    case PAWN: return new Pawn(isWhite, x, y);
+    case KNIGHT: return new Knight(isWhite, x, y);
+    case BISHOP: return new Bishop(isWhite, x, y);
+    case ROOK: return new Rook(isWhite, x, y);
+    case QUEEN: return new Queen(isWhite, x, y);
+    default: return new King(isWhite, x, y);
+    }
 }
 
-PieceManager::~PieceManager() {
-    for (int x = 0; x < 8; x++) {
-        for (int y = 0; y < 8; y++) {
-            delete board[x][y];
-        }
+void PieceManager::createSprites() {
+    for (int sq = 0; sq < 64; sq++) {
+        PieceCode pc = position.pieceOn(sq);
+        sprites[sq] = pc == NO_PIECE ? nullptr : createPiece(pc, sq);
     }
 }
 
@@ -58,58 +51,103 @@ PieceManager* PieceManager::getInstance() {
 
 // Rendering methods
 
-void PieceManager::renderPieces() {
-    for (int x = 0; x < 8; x++) {
-        for (int y = 0; y < 8; y++) {
-            if (board[x][y]) {
-                board[x][y]->render();
-            }
+void PieceManager::renderPieces(RenderBatch& batch) {
+    PROFILE_FUNCTION();
+    for (int sq = 0; sq < 64; sq++) {
+        if (sprites[sq]) {
+            sprites[sq]->render(batch);
         }
     }
 }
 
 // Mouse methods
 
-std::vector<std::pair<int, int>> PieceManager::mouseDown(const Piece* piece, int x, int y) {
+void PieceManager::rebuildHitMasks() {
+    for (int pc = 0; pc < 2 * PIECE_TYPE_NB; pc++) {
+        hitMasks[pc] = Piece::atlas->getMask(pc).scaled(Piece::board_size, Piece::board_size);
+    }
+}
+
+void PieceManager::mouseDown(const Piece* piece, int x, int y, MoveList& moves) {
+    PROFILE_FUNCTION();
+    moves.clear();
     SDL_Point clickPoint = { x, y };
     if (piece) {
         // Check if the click is within the piece
         SDL_Rect* rect = piece->getRect();
         if (SDL_PointInRect(&clickPoint, rect)) {
-            // Relative position logic
+            // Relative position logic, the mask already has the cell's size
             int relativeX = x - rect->x;
             int relativeY = y - rect->y;
-            SDL_Surface* surface = piece->getSurface();
-            int w = surface->w;
-            int h = surface->h;
-            // Ensure relative positions are in the cell
-            if (relativeX >= 0 && relativeX < w && relativeY >= 0 && relativeY < h) {
-                Uint32* pixels = (Uint32*)surface->pixels;
-                int pixelIndex = relativeY * surface->w + relativeX;
-                Uint32 pixel = pixels[pixelIndex];
-
-                // Check alpha
-                Uint8 alpha = (pixel & surface->format->Amask) >> surface->format->Ashift;
-
-                if (alpha > ALPHA_THRESHOLD) {
-                    return piece->getValidMoves(board);
+
+            // Check the opacity bit
+            if (hitMasks[piece->getPieceCode()].test(relativeX, relativeY)) {
+                // Keep only the moves of the clicked piece
+                MoveList all;
+                generateMoves(position, all);
+                for (const Move& move : all) {
+                    if (move.getFrom() == piece->getSquare()) {
+                        moves.add(move);
+                    }
                 }
             }
         }
     }
-    return std::vector<std::pair<int, int>>();
 }
 
 // Getters & Setters 
 
-Piece* PieceManager::getPiece(int x, int y) const{
-    return board[x][y];
+const Position& PieceManager::getPosition() const {
+    return position;
 }
 
-void PieceManager::movePiece(Piece* piece, int x, int y) {
-    std::pair<int, int> cords = piece->getCords();
-	board[cords.first][cords.second] = nullptr;
-	piece->setCords(x, y);
-	board[x][y] = piece;
+bool PieceManager::setPosition(const std::string& fen) {
+    Position next;
+    if (!next.setFen(fen)) {
+        return false;
+    }
+    for (int sq = 0; sq < 64; sq++) {
+        delete sprites[sq];
+    }
+    position = next;
+    createSprites();
+    return true;
 }
 
+bool PieceManager::isWhiteToMove() const {
+    return position.getSideToMove() == WHITE;
+}
+
+Piece* PieceManager::getPiece(int x, int y) const{
+    return sprites[squareFromCords(x, y)];
+}
+
+void PieceManager::movePiece(Move move) {
+    PROFILE_FUNCTION();
+    int from = move.getFrom();
+    int to = move.getTo();
+    int captured = move.getFlags() == EP_CAPTURE ? squareFromCords(cordsX(to), cordsY(from)) : to;
+    Piece* piece = sprites[from];
+
+    delete sprites[captured];
+    sprites[captured] = nullptr;
+    sprites[from] = nullptr;
+    piece->setCords(cordsX(to), cordsY(to));
+    sprites[to] = piece;
+
+    if (move.getFlags() == KING_CASTLE || move.getFlags() == QUEEN_CASTLE) {
+        int rookFrom, rookTo;
+        Position::castlingRookSquares(to, rookFrom, rookTo);
+        sprites[rookTo] = sprites[rookFrom];
+        sprites[rookFrom] = nullptr;
+        sprites[rookTo]->setCords(cordsX(rookTo), cordsY(rookTo));
+    }
+
+    position.makeMove(move);
+
+    // The pawn sprite is swapped for the promoted piece
+    if (move.isPromotion()) {
+        delete sprites[to];
+        sprites[to] = createPiece(position.pieceOn(to), to);
+    }
+}
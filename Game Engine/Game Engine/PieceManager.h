@@ -2,26 +2,42 @@
 #include <iostream>
 #include <SDL.h>
 #include "Piece.h"
+#include "Position.h"
+#include "MoveGen.h"
+#include "Attacks.h"
+#include "Profiler.h"
 #define BOARD_LENGTH 8
-#define ALPHA_THRESHOLD 0
 
 // Singlton class for now
 
 class PieceManager {
     static PieceManager* instance;
-    Piece* board[BOARD_LENGTH][BOARD_LENGTH]; // Board array of pieces, considered using a vector for exisiting pieces but this is simpler and does not affect performance.
+    Position position; // Bitboard position, the source of truth for the game
+    Piece* sprites[64]; // Pieces indexed by square, only used for rendering and picking
+    HitMask hitMasks[2 * PIECE_TYPE_NB]; // Per piece code, scaled to the cell size on screen
 
     PieceManager();
     ~PieceManager();
     PieceManager(const PieceManager&) = delete;
     PieceManager& operator=(const PieceManager&) = delete;
+
+    Piece* createPiece(PieceCode pc, int sq) const;
+    void createSprites();
 public:
     static PieceManager* getInstance();
 
-    void renderPieces();
+    void renderPieces(RenderBatch& batch);
+
+    // Rescales the hit masks from the atlas to Piece::board_size, call again when the board is resized
+    void rebuildHitMasks();
+
+    void mouseDown(const Piece* piece, int x, int y, MoveList& moves);
 
-    std::vector<std::pair<int, int>> mouseDown(const Piece* piece, int x, int y);
+    const Position& getPosition() const;
+    // Replaces the game with the FEN and rebuilds every sprite, false if the FEN is rejected
+    bool setPosition(const std::string& fen);
+    bool isWhiteToMove() const;
 
     Piece* getPiece(int x, int y) const;
-    void movePiece(Piece* piece, int x, int y);
+    void movePiece(Move move);
 };
@@ -0,0 +1,524 @@
+#include "Position.h"
+#include <algorithm>
+#include <sstream>
+
+// Constructor
+
+Position::Position() {
+    clear();
+}
+
+void Position::clear() {
+    for (int c = 0; c < COLOR_NB; c++) {
+        for (int pt = 0; pt < PIECE_TYPE_NB; pt++) {
+            pieces[c][pt] = 0;
+        }
+        colors[c] = 0;
+    }
+    occupied = 0;
+    for (int sq = 0; sq < 64; sq++) {
+        board[sq] = NO_PIECE;
+    }
+    sideToMove = WHITE;
+    castlingRights = 0;
+    epSquare = NO_SQUARE;
+    halfmoveClock = 0;
+    fullmoveNumber = 1;
+    historySize = 0;
+    key = 0;
+    pawnKey = 0;
+    psqtScore = 0;
+    phase = 0;
+    accumulator.generation = 0;
+}
+
+// Zobrist keys and piece-square sum
+
+namespace {
+    // The en-passant square only enters the key when a pawn could actually take,
+    // so positions that differ by a useless double push still transpose
+    bool epCapturable(const Position& position, int epSquare) {
+        Color us = position.getSideToMove();
+        return epSquare != NO_SQUARE && (attacks::pawnAttacks(Color(us ^ 1), epSquare) & position.getPieces(us, PAWN));
+    }
+}
+
+uint64_t Position::computeKey() const {
+    uint64_t k = 0;
+    for (int sq = 0; sq < 64; sq++) {
+        if (board[sq] != NO_PIECE) {
+            k ^= zobrist::pieceSquare(board[sq], sq);
+        }
+    }
+    k ^= zobrist::castling(castlingRights);
+    if (epCapturable(*this, epSquare)) {
+        k ^= zobrist::enPassant(epSquare);
+    }
+    if (sideToMove == BLACK) {
+        k ^= zobrist::side();
+    }
+    return k;
+}
+
+uint64_t Position::computePawnKey() const {
+    uint64_t k = 0;
+    Bitboard pawns = pieces[WHITE][PAWN] | pieces[BLACK][PAWN];
+    while (pawns) {
+        int sq = popLsb(pawns);
+        k ^= zobrist::pieceSquare(board[sq], sq);
+    }
+    return k;
+}
+
+Score Position::computePsqtScore() const {
+    Score s = 0;
+    for (int sq = 0; sq < 64; sq++) {
+        if (board[sq] != NO_PIECE) {
+            s += psqt::value(board[sq], sq);
+        }
+    }
+    return s;
+}
+
+void Position::refreshAccumulator() {
+    nnue::refresh(*this, accumulator, WHITE);
+    nnue::refresh(*this, accumulator, BLACK);
+    accumulator.generation = nnue::getGeneration();
+}
+
+// FEN parsing, returns false and leaves the position cleared on malformed input
+
+bool Position::setFen(const std::string& fen) {
+    static const std::string pieceChars = "PNBRQKpnbrqk";
+
+    clear();
+    std::istringstream ss(fen);
+    std::string placement, side, castling, ep;
+    ss >> placement >> side >> castling >> ep;
+
+    int file = 0;
+    int rank = 7;
+    for (char ch : placement) {
+        if (ch == '/') {
+            if (file != 8 || rank == 0) {
+                clear();
+                return false;
+            }
+            file = 0;
+            rank--;
+        }
+        else if (ch >= '1' && ch <= '8') {
+            file += ch - '0';
+        }
+        else {
+            size_t index = pieceChars.find(ch);
+            if (index == std::string::npos || file > 7) {
+                clear();
+                return false;
+            }
+            putPiece(Color(index / PIECE_TYPE_NB), PieceType(index % PIECE_TYPE_NB), makeSquare(file, rank));
+            file++;
+        }
+        if (file > 8) {
+            clear();
+            return false;
+        }
+    }
+    if (rank != 0 || file != 8) {
+        clear();
+        return false;
+    }
+    // Move lists and the network accumulator are sized for what a real game can reach
+    for (int c = 0; c < COLOR_NB; c++) {
+        if (popcount(pieces[c][KING]) != 1 || popcount(pieces[c][PAWN]) > 8 || popcount(colors[c]) > 16) {
+            clear();
+            return false;
+        }
+    }
+
+    if (side == "w" || side == "b") {
+        sideToMove = side == "w" ? WHITE : BLACK;
+    }
+    else {
+        clear();
+        return false;
+    }
+
+    for (char ch : castling) {
+        switch (ch) {
+        case 'K': castlingRights |= WHITE_OO; break;
+        case 'Q': castlingRights |= WHITE_OOO; break;
+        case 'k': castlingRights |= BLACK_OO; break;
+        case 'q': castlingRights |= BLACK_OOO; break;
+        case '-': break;
+        default:
+            clear();
+            return false;
+        }
+    }
+
+    // Rights the king and rook placement cannot back are dropped rather than trusted
+    if (board[E1] != makePiece(WHITE, KING)) {
+        castlingRights &= ~(WHITE_OO | WHITE_OOO);
+    }
+    if (board[E8] != makePiece(BLACK, KING)) {
+        castlingRights &= ~(BLACK_OO | BLACK_OOO);
+    }
+    if (board[H1] != makePiece(WHITE, ROOK)) {
+        castlingRights &= ~WHITE_OO;
+    }
+    if (board[A1] != makePiece(WHITE, ROOK)) {
+        castlingRights &= ~WHITE_OOO;
+    }
+    if (board[H8] != makePiece(BLACK, ROOK)) {
+        castlingRights &= ~BLACK_OO;
+    }
+    if (board[A8] != makePiece(BLACK, ROOK)) {
+        castlingRights &= ~BLACK_OOO;
+    }
+
+    // Only kept when a pawn of the other side just made the double step through it
+    if (ep.size() == 2 && ep[0] >= 'a' && ep[0] <= 'h' && ep[1] == (sideToMove == WHITE ? '6' : '3')) {
+        int sq = makeSquare(ep[0] - 'a', ep[1] - '1');
+        int up = sideToMove == WHITE ? 8 : -8;
+        if (board[sq - up] == makePiece(Color(sideToMove ^ 1), PAWN) && board[sq] == NO_PIECE && board[sq + up] == NO_PIECE) {
+            epSquare = sq;
+        }
+    }
+
+    // The move counters are optional in a lot of FENs found in the wild
+    if (!(ss >> halfmoveClock)) {
+        halfmoveClock = 0;
+    }
+    if (!(ss >> fullmoveNumber)) {
+        fullmoveNumber = 1;
+    }
+    key = computeKey();
+    if (nnue::isEnabled()) {
+        refreshAccumulator();
+    }
+    return true;
+}
+
+std::string Position::getFen() const {
+    static const std::string pieceChars = "PNBRQKpnbrqk";
+
+    std::string fen;
+    for (int rank = 7; rank >= 0; rank--) {
+        int empty = 0;
+        for (int file = 0; file < 8; file++) {
+            PieceCode pc = board[makeSquare(file, rank)];
+            if (pc == NO_PIECE) {
+                empty++;
+                continue;
+            }
+            if (empty) {
+                fen += char('0' + empty);
+                empty = 0;
+            }
+            fen += pieceChars[int(colorOf(pc)) * PIECE_TYPE_NB + typeOf(pc)];
+        }
+        if (empty) {
+            fen += char('0' + empty);
+        }
+        if (rank) {
+            fen += '/';
+        }
+    }
+
+    fen += sideToMove == WHITE ? " w " : " b ";
+    if (!castlingRights) {
+        fen += '-';
+    }
+    // Rights are one bit each in KQkq order
+    for (int i = 0; i < 4; i++) {
+        if (castlingRights & (1 << i)) {
+            fen += "KQkq"[i];
+        }
+    }
+
+    fen += ' ';
+    if (epSquare != NO_SQUARE) {
+        fen += char('a' + fileOf(epSquare));
+        fen += char('1' + rankOf(epSquare));
+    }
+    else {
+        fen += '-';
+    }
+    return fen + ' ' + std::to_string(halfmoveClock) + ' ' + std::to_string(fullmoveNumber);
+}
+
+// Moves
+
+namespace {
+    // Castling rights that survive a move touching the square
+    constexpr int castlingMask(int sq) {
+        switch (sq) {
+        case A1: return ALL_CASTLING & ~WHITE_OOO;
+        case E1: return ALL_CASTLING & ~(WHITE_OO | WHITE_OOO);
+        case H1: return ALL_CASTLING & ~WHITE_OO;
+        case A8: return ALL_CASTLING & ~BLACK_OOO;
+        case E8: return ALL_CASTLING & ~(BLACK_OO | BLACK_OOO);
+        case H8: return ALL_CASTLING & ~BLACK_OO;
+        default: return ALL_CASTLING;
+        }
+    }
+}
+
+// A full history forgets its older half. Repetitions only look back halfmoveClock plies and
+// past 100 of them the game is drawn anyway, the forgotten moves can no longer be taken back.
+UndoInfo& Position::pushUndo() {
+    if (historySize == MAX_GAME_PLY) {
+        std::copy(history + MAX_GAME_PLY / 2, history + MAX_GAME_PLY, history);
+        historySize -= MAX_GAME_PLY / 2;
+    }
+    return history[historySize++];
+}
+
+void Position::makeMove(Move move) {
+    int from = move.getFrom();
+    int to = move.getTo();
+    int flags = move.getFlags();
+    Color us = sideToMove;
+    PieceCode moving = board[from];
+
+    UndoInfo& undo = pushUndo();
+    undo.move = move;
+    undo.captured = NO_PIECE;
+    undo.castlingRights = castlingRights;
+    undo.epSquare = epSquare;
+    undo.halfmoveClock = halfmoveClock;
+    undo.key = key;
+
+    key ^= zobrist::castling(castlingRights) ^ zobrist::side();
+    if (epCapturable(*this, epSquare)) {
+        key ^= zobrist::enPassant(epSquare);
+    }
+
+    if (move.isCapture()) {
+        int captured = flags == EP_CAPTURE ? (us == WHITE ? to - 8 : to + 8) : to;
+        undo.captured = board[captured];
+        removePiece(captured);
+    }
+    movePiece(from, to);
+
+    if (flags == KING_CASTLE || flags == QUEEN_CASTLE) {
+        int rookFrom, rookTo;
+        castlingRookSquares(to, rookFrom, rookTo);
+        movePiece(rookFrom, rookTo);
+    }
+    else if (move.isPromotion()) {
+        removePiece(to);
+        putPiece(us, move.getPromotion(), to);
+    }
+
+    castlingRights &= castlingMask(from) & castlingMask(to);
+    epSquare = flags == DOUBLE_PUSH ? (from + to) / 2 : NO_SQUARE;
+    halfmoveClock = (move.isCapture() || typeOf(moving) == PAWN) ? 0 : halfmoveClock + 1;
+    if (us == BLACK) {
+        fullmoveNumber++;
+    }
+    sideToMove = Color(us ^ 1);
+
+    key ^= zobrist::castling(castlingRights);
+    if (epCapturable(*this, epSquare)) {
+        key ^= zobrist::enPassant(epSquare);
+    }
+
+    if (nnue::isEnabled()) {
+        updateAccumulator(move, moving, undo.captured, false);
+    }
+    else {
+        accumulator.generation = 0;
+    }
+}
+
+void Position::unmakeMove() {
+    const UndoInfo& undo = history[--historySize];
+    Move move = undo.move;
+    int from = move.getFrom();
+    int to = move.getTo();
+    int flags = move.getFlags();
+    Color us = Color(sideToMove ^ 1);
+
+    if (move.isPromotion()) {
+        removePiece(to);
+        putPiece(us, PAWN, to);
+    }
+    else if (flags == KING_CASTLE || flags == QUEEN_CASTLE) {
+        int rookFrom, rookTo;
+        castlingRookSquares(to, rookFrom, rookTo);
+        movePiece(rookTo, rookFrom);
+    }
+    movePiece(to, from);
+
+    if (undo.captured != NO_PIECE) {
+        int captured = flags == EP_CAPTURE ? (us == WHITE ? to - 8 : to + 8) : to;
+        putPiece(colorOf(undo.captured), typeOf(undo.captured), captured);
+    }
+
+    castlingRights = undo.castlingRights;
+    epSquare = undo.epSquare;
+    halfmoveClock = undo.halfmoveClock;
+    key = undo.key;
+    if (us == BLACK) {
+        fullmoveNumber--;
+    }
+    sideToMove = us;
+
+    if (nnue::isEnabled()) {
+        updateAccumulator(move, board[from], undo.captured, true);
+    }
+    else {
+        accumulator.generation = 0;
+    }
+}
+
+// Network accumulator. A move only adds and removes the features of the pieces it touches,
+// except for the side whose king moved: every feature of that side is relative to its king.
+
+void Position::updateAccumulator(Move move, PieceCode moving, PieceCode captured, bool undo) {
+    if (accumulator.generation != nnue::getGeneration()) {
+        refreshAccumulator();
+        return;
+    }
+
+    int to = move.getTo();
+    Color us = colorOf(moving);
+
+    // Pieces the move lifts off and sets down, seen in the direction of play
+    PieceCode offPieces[2];
+    PieceCode onPieces[2];
+    int offSquares[2];
+    int onSquares[2];
+    int offCount = 0;
+    int onCount = 0;
+    offPieces[offCount] = moving;
+    offSquares[offCount++] = move.getFrom();
+    onPieces[onCount] = move.isPromotion() ? makePiece(us, move.getPromotion()) : moving;
+    onSquares[onCount++] = to;
+    if (captured != NO_PIECE) {
+        offPieces[offCount] = captured;
+        offSquares[offCount++] = move.getFlags() == EP_CAPTURE ? (us == WHITE ? to - 8 : to + 8) : to;
+    }
+    if (move.getFlags() == KING_CASTLE || move.getFlags() == QUEEN_CASTLE) {
+        int rookFrom, rookTo;
+        castlingRookSquares(to, rookFrom, rookTo);
+        offPieces[offCount] = onPieces[onCount] = makePiece(us, ROOK);
+        offSquares[offCount++] = rookFrom;
+        onSquares[onCount++] = rookTo;
+    }
+
+    for (Color c : { WHITE, BLACK }) {
+        if (c == us && typeOf(moving) == KING) {
+            nnue::refresh(*this, accumulator, c);
+            continue;
+        }
+
+        // Kings are not features, only the other pieces relative to them
+        int king = getKingSquare(c);
+        int removed[2];
+        int added[2];
+        int removedCount = 0;
+        int addedCount = 0;
+        for (int i = 0; i < offCount; i++) {
+            if (typeOf(offPieces[i]) != KING) {
+                removed[removedCount++] = nnue::featureIndex(c, king, offPieces[i], offSquares[i]);
+            }
+        }
+        for (int i = 0; i < onCount; i++) {
+            if (typeOf(onPieces[i]) != KING) {
+                added[addedCount++] = nnue::featureIndex(c, king, onPieces[i], onSquares[i]);
+            }
+        }
+
+        if (undo) {
+            nnue::update(accumulator, c, removed, removedCount, added, addedCount);
+        }
+        else {
+            nnue::update(accumulator, c, added, addedCount, removed, removedCount);
+        }
+    }
+}
+
+void Position::makeNullMove() {
+    UndoInfo& undo = pushUndo();
+    undo.move = Move();
+    undo.captured = NO_PIECE;
+    undo.castlingRights = castlingRights;
+    undo.epSquare = epSquare;
+    undo.halfmoveClock = halfmoveClock;
+    undo.key = key;
+
+    if (epCapturable(*this, epSquare)) {
+        key ^= zobrist::enPassant(epSquare);
+    }
+    key ^= zobrist::side();
+    epSquare = NO_SQUARE;
+    // Repetitions are not looked for across a null move
+    halfmoveClock = 0;
+    sideToMove = Color(sideToMove ^ 1);
+}
+
+void Position::unmakeNullMove() {
+    const UndoInfo& undo = history[--historySize];
+    epSquare = undo.epSquare;
+    halfmoveClock = undo.halfmoveClock;
+    key = undo.key;
+    sideToMove = Color(sideToMove ^ 1);
+}
+
+// Draw detection
+
+bool Position::isDraw() const {
+    if (halfmoveClock >= 100) {
+        return true;
+    }
+
+    // Only positions with the same side to move since the last capture or pawn move can repeat
+    for (int i = historySize - 2; i >= 0 && i >= historySize - halfmoveClock; i -= 2) {
+        if (history[i].key == key) {
+            return true;
+        }
+    }
+
+    return isMaterialDraw();
+}
+
+int Position::getRepetitionCount() const {
+    int count = 0;
+    for (int i = historySize - 2; i >= 0 && i >= historySize - halfmoveClock; i -= 2) {
+        if (history[i].key == key) {
+            count++;
+        }
+    }
+    return count;
+}
+
+bool Position::isMaterialDraw() const {
+    // King and at most one minor piece against a bare king
+    Bitboard heavy = pieces[WHITE][PAWN] | pieces[BLACK][PAWN] | pieces[WHITE][ROOK] | pieces[BLACK][ROOK]
+        | pieces[WHITE][QUEEN] | pieces[BLACK][QUEEN];
+    return !heavy && popcount(occupied) <= 3;
+}
+
+// Attack queries
+
+Bitboard Position::attackersTo(int sq, Bitboard occupied) const {
+    Bitboard rooks = pieces[WHITE][ROOK] | pieces[BLACK][ROOK] | pieces[WHITE][QUEEN] | pieces[BLACK][QUEEN];
+    Bitboard bishops = pieces[WHITE][BISHOP] | pieces[BLACK][BISHOP] | pieces[WHITE][QUEEN] | pieces[BLACK][QUEEN];
+    return (attacks::pawnAttacks(BLACK, sq) & pieces[WHITE][PAWN])
+        | (attacks::pawnAttacks(WHITE, sq) & pieces[BLACK][PAWN])
+        | (attacks::knightAttacks(sq) & (pieces[WHITE][KNIGHT] | pieces[BLACK][KNIGHT]))
+        | (attacks::kingAttacks(sq) & (pieces[WHITE][KING] | pieces[BLACK][KING]))
+        | (attacks::rookAttacks(sq, occupied) & rooks)
+        | (attacks::bishopAttacks(sq, occupied) & bishops);
+}
+
+bool Position::isAttacked(int sq, Color by) const {
+    return attackersTo(sq, occupied) & colors[by];
+}
+
+bool Position::isInCheck() const {
+    return isAttacked(getKingSquare(sideToMove), Color(sideToMove ^ 1));
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <string>
+#include "Bitboard.h"
+#include "Move.h"
+#include "Attacks.h"
+#include "Zobrist.h"
+#include "Psqt.h"
+#include "Nnue.h"
+
+#define START_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+#define MAX_GAME_PLY 2048
+
+// Everything makeMove destroys and unmakeMove needs back
+struct UndoInfo {
+    Move move;
+    PieceCode captured;
+    int castlingRights;
+    int epSquare;
+    int halfmoveClock;
+    uint64_t key;
+};
+
+// Compact bitboard position, the source of truth for the game state.
+// Moves are made and unmade in place, the undo records live on a preallocated
+// stack inside the position so lookahead never copies or allocates.
+
+class Position {
+    Bitboard pieces[COLOR_NB][PIECE_TYPE_NB];
+    Bitboard colors[COLOR_NB];
+    Bitboard occupied;
+    PieceCode board[64]; // Mailbox mirror of the bitboards for O(1) square lookups
+
+    Color sideToMove;
+    int castlingRights;
+    int epSquare;
+    int halfmoveClock;
+    int fullmoveNumber;
+    uint64_t key; // Zobrist key, kept up to date incrementally
+    uint64_t pawnKey; // Zobrist key of the pawns alone, for the pawn structure cache
+    Score psqtScore; // Material and piece-square sum from white's side, also incremental
+    int phase; // Sum of the phase weights of the pieces on the board
+    Accumulator accumulator; // Network first layer, updated by the moves while a network is in use
+
+    UndoInfo history[MAX_GAME_PLY];
+    int historySize;
+
+    void updateAccumulator(Move move, PieceCode moving, PieceCode captured, bool undo);
+    UndoInfo& pushUndo();
+public:
+    Position();
+
+    void clear();
+    bool setFen(const std::string& fen);
+    std::string getFen() const;
+
+    // Full Zobrist key recomputation, the incremental key must always match it
+    uint64_t computeKey() const;
+    // Same for the pawn key and the piece-square sum
+    uint64_t computePawnKey() const;
+    Score computePsqtScore() const;
+    // Rebuilds the network accumulator of both sides for the loaded network
+    void refreshAccumulator();
+
+    // Plays a legal move, special moves included, and passes the turn
+    void makeMove(Move move);
+    // Takes back the last move made, up to the last MAX_GAME_PLY / 2 of them
+    void unmakeMove();
+
+    // Passes the turn without moving, used by null-move pruning
+    void makeNullMove();
+    void unmakeNullMove();
+
+    // Fifty-move rule, repetition since the last irreversible move, or bare minors. A single
+    // repetition is enough for the search, games go by getRepetitionCount().
+    bool isDraw() const;
+    // Times the position occurred before since the last irreversible move, 2 is a three-fold
+    int getRepetitionCount() const;
+    // King and at most one minor piece against a bare king
+    bool isMaterialDraw() const;
+
+    // Rook squares of a castling move, given where the king lands
+    static void castlingRookSquares(int kingTo, int& rookFrom, int& rookTo) {
+        rookFrom = fileOf(kingTo) == 6 ? kingTo + 1 : kingTo - 2;
+        rookTo = fileOf(kingTo) == 6 ? kingTo - 1 : kingTo + 1;
+    }
+
+    // Attack queries
+    Bitboard attackersTo(int sq, Bitboard occupied) const;
+    bool isAttacked(int sq, Color by) const;
+    bool isInCheck() const;
+
+    // Board editing, kept inline since every move goes through these
+    void putPiece(Color c, PieceType pt, int sq) {
+        Bitboard b = squareBB(sq);
+        pieces[c][pt] |= b;
+        colors[c] |= b;
+        occupied |= b;
+        board[sq] = makePiece(c, pt);
+        key ^= zobrist::pieceSquare(board[sq], sq);
+        if (pt == PAWN) {
+            pawnKey ^= zobrist::pieceSquare(board[sq], sq);
+        }
+        psqtScore += psqt::value(board[sq], sq);
+        phase += psqt::phase(board[sq]);
+    }
+
+    void removePiece(int sq) {
+        PieceCode pc = board[sq];
+        Bitboard b = squareBB(sq);
+        pieces[colorOf(pc)][typeOf(pc)] ^= b;
+        colors[colorOf(pc)] ^= b;
+        occupied ^= b;
+        board[sq] = NO_PIECE;
+        key ^= zobrist::pieceSquare(pc, sq);
+        if (typeOf(pc) == PAWN) {
+            pawnKey ^= zobrist::pieceSquare(pc, sq);
+        }
+        psqtScore -= psqt::value(pc, sq);
+        phase -= psqt::phase(pc);
+    }
+
+    void movePiece(int from, int to) {
+        PieceCode pc = board[from];
+        Bitboard b = squareBB(from) | squareBB(to);
+        pieces[colorOf(pc)][typeOf(pc)] ^= b;
+        colors[colorOf(pc)] ^= b;
+        occupied ^= b;
+        board[from] = NO_PIECE;
+        board[to] = pc;
+        key ^= zobrist::pieceSquare(pc, from) ^ zobrist::pieceSquare(pc, to);
+        if (typeOf(pc) == PAWN) {
+            pawnKey ^= zobrist::pieceSquare(pc, from) ^ zobrist::pieceSquare(pc, to);
+        }
+        psqtScore += psqt::value(pc, to) - psqt::value(pc, from);
+    }
+
+    // Getters
+    Bitboard getPieces(Color c, PieceType pt) const { return pieces[c][pt]; }
+    Bitboard getPieces(Color c) const { return colors[c]; }
+    Bitboard getOccupied() const { return occupied; }
+    PieceCode pieceOn(int sq) const { return board[sq]; }
+    int getKingSquare(Color c) const { return lsb(pieces[c][KING]); }
+    bool hasNonPawnMaterial(Color c) const { return colors[c] ^ pieces[c][PAWN] ^ pieces[c][KING]; }
+
+    Color getSideToMove() const { return sideToMove; }
+    int getCastlingRights() const { return castlingRights; }
+    int getEnPassantSquare() const { return epSquare; }
+    int getHalfmoveClock() const { return halfmoveClock; }
+    int getFullmoveNumber() const { return fullmoveNumber; }
+    int getHistorySize() const { return historySize; }
+    uint64_t getKey() const { return key; }
+    uint64_t getPawnKey() const { return pawnKey; }
+    Score getPsqtScore() const { return psqtScore; }
+    int getPhase() const { return phase; }
+    const Accumulator& getAccumulator() const { return accumulator; }
+    Move getLastMove() const { return historySize ? history[historySize - 1].move : Move(); }
+};
@@ -0,0 +1,143 @@
+#include "Profiler.h"
+
+#if defined(ENABLE_PROFILER)
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+namespace profiler {
+    namespace {
+        struct TraceEvent {
+            const char* name;
+            uint64_t startUs;
+            uint64_t durationUs;
+            int thread;
+        };
+
+        const auto epoch = std::chrono::steady_clock::now();
+
+        std::mutex eventMutex;
+        std::vector<TraceEvent> events(PROFILER_EVENT_CAPACITY);
+        uint64_t eventCount = 0; // Total ever recorded, the ring holds the last PROFILER_EVENT_CAPACITY
+
+        // Frames are opened and closed by the render thread only
+        float frameTimes[PROFILER_FRAME_HISTORY];
+        uint64_t frameEnds[PROFILER_FRAME_HISTORY];
+        uint64_t frameCount = 0;
+        uint64_t frameStart = 0;
+        uint32_t lastDrawCalls = 0;
+
+        int threadIndex() {
+            static std::atomic<int> next{ 0 };
+            thread_local int index = next++;
+            return index;
+        }
+
+        void writeEscaped(std::ofstream& out, const char* text) {
+            for (; *text; text++) {
+                if (*text == '"' || *text == '\\') {
+                    out << '\\';
+                }
+                out << *text;
+            }
+        }
+    }
+
+    uint64_t nowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    void record(const char* name, uint64_t startUs, uint64_t endUs) {
+        int thread = threadIndex();
+        std::lock_guard<std::mutex> lock(eventMutex);
+        events[eventCount++ % PROFILER_EVENT_CAPACITY] = { name, startUs, endUs - startUs, thread };
+    }
+
+    // Frames
+
+    void beginFrame() {
+        frameStart = nowUs();
+    }
+
+    void endFrame(uint32_t drawCalls) {
+        uint64_t end = nowUs();
+        record("frame", frameStart, end);
+        frameTimes[frameCount % PROFILER_FRAME_HISTORY] = (end - frameStart) / 1000.0f;
+        frameEnds[frameCount % PROFILER_FRAME_HISTORY] = end;
+        frameCount++;
+        lastDrawCalls = drawCalls;
+    }
+
+    int getFrameTimes(float* out, int count) {
+        int available = int(std::min<uint64_t>(frameCount, PROFILER_FRAME_HISTORY));
+        count = std::min(count, available);
+        for (int i = 0; i < count; i++) {
+            out[i] = frameTimes[(frameCount - count + i) % PROFILER_FRAME_HISTORY];
+        }
+        return count;
+    }
+
+    FrameStats getFrameStats() {
+        FrameStats stats;
+        stats.drawCalls = lastDrawCalls;
+        float sorted[PROFILER_FRAME_HISTORY];
+        stats.frames = getFrameTimes(sorted, PROFILER_FRAME_HISTORY);
+        if (!stats.frames) {
+            return stats;
+        }
+        std::sort(sorted, sorted + stats.frames);
+        auto percentile = [&](int p) { return sorted[std::min(stats.frames - 1, stats.frames * p / 100)]; };
+        stats.p50 = percentile(50);
+        stats.p95 = percentile(95);
+        stats.p99 = percentile(99);
+        stats.max = sorted[stats.frames - 1];
+
+        // Frames presented during the last second
+        uint64_t now = nowUs();
+        for (int i = 0; i < stats.frames; i++) {
+            if (now - frameEnds[(frameCount - 1 - i) % PROFILER_FRAME_HISTORY] <= 1000000) {
+                stats.fps++;
+            }
+        }
+        return stats;
+    }
+
+    // Trace export
+
+    bool exportChromeTrace(const std::string& path) {
+        std::ofstream out(path);
+        if (!out) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(eventMutex);
+        uint64_t first = eventCount > PROFILER_EVENT_CAPACITY ? eventCount - PROFILER_EVENT_CAPACITY : 0;
+        out << "{\"traceEvents\":[";
+        for (uint64_t i = first; i < eventCount; i++) {
+            const TraceEvent& event = events[i % PROFILER_EVENT_CAPACITY];
+            out << (i == first ? "\n" : ",\n") << "{\"name\":\"";
+            writeEscaped(out, event.name);
+            out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread << ",\"ts\":" << event.startUs << ",\"dur\":" << event.durationUs << "}";
+        }
+        out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+        return bool(out);
+    }
+}
+
+#else
+
+// Stubs so callers that skip the macros still link, nothing is ever recorded
+namespace profiler {
+    uint64_t nowUs() { return 0; }
+    void record(const char*, uint64_t, uint64_t) {}
+    void beginFrame() {}
+    void endFrame(uint32_t) {}
+    FrameStats getFrameStats() { return FrameStats(); }
+    int getFrameTimes(float*, int) { return 0; }
+    bool exportChromeTrace(const std::string&) { return false; }
+}
+
+#endif
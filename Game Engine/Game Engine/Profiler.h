@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// ======================
+// Scoped-timer instrumentation (no SDL in here)
+// ======================
+// Built with ENABLE_PROFILER, PROFILE_SCOPE records a begin/duration pair into a ring
+// buffer and PROFILE_END_FRAME closes a frame into a second ring of frame times. Without
+// it every macro expands to nothing, so the hot paths carry no cost at all.
+
+#define PROFILER_EVENT_CAPACITY (1 << 16) // Last scopes kept for the trace export
+#define PROFILER_FRAME_HISTORY 256 // Last frames kept for the statistics
+
+namespace profiler {
+
+    // Summary of the frames in the history ring, times in milliseconds
+    struct FrameStats {
+        int frames = 0;
+        float fps = 0;
+        float p50 = 0;
+        float p95 = 0;
+        float p99 = 0;
+        float max = 0;
+        uint32_t drawCalls = 0; // Of the last frame
+    };
+
+    uint64_t nowUs();
+
+    // Safe to call from any thread, each thread shows up as its own track in the trace
+    void record(const char* name, uint64_t startUs, uint64_t endUs);
+
+    void beginFrame();
+    void endFrame(uint32_t drawCalls);
+    FrameStats getFrameStats();
+    // Copies the last count frame times (milliseconds, oldest first), returns how many were copied
+    int getFrameTimes(float* out, int count);
+
+    // Writes the recorded scopes in the Chrome trace event format (chrome://tracing, Perfetto)
+    bool exportChromeTrace(const std::string& path);
+
+    class ScopedTimer {
+        const char* name;
+        uint64_t start;
+    public:
+        ScopedTimer(const char* name) : name(name), start(nowUs()) {}
+        ~ScopedTimer() { record(name, start, nowUs()); }
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+    };
+}
+
+#if defined(ENABLE_PROFILER)
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) profiler::ScopedTimer PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+#define PROFILE_BEGIN_FRAME() profiler::beginFrame()
+#define PROFILE_END_FRAME(drawCalls) profiler::endFrame(drawCalls)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_FUNCTION() ((void)0)
+#define PROFILE_BEGIN_FRAME() ((void)0)
+#define PROFILE_END_FRAME(drawCalls) ((void)0)
+#endif
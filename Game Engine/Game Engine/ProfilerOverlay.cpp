@@ -0,0 +1,103 @@
+#include "ProfilerOverlay.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+    // 3x5 glyphs, rows from the top, '1' marks a lit pixel
+    struct Glyph {
+        char c;
+        const char* rows;
+    };
+
+    const Glyph font[] = {
+        { '0', "111101101101111" }, { '1', "010110010010111" }, { '2', "111001111100111" },
+        { '3', "111001111001111" }, { '4', "101101111001001" }, { '5', "111100111001111" },
+        { '6', "111100111101111" }, { '7', "111001001001001" }, { '8', "111101111101111" },
+        { '9', "111101111001111" }, { '.', "000000000000010" }, { ':', "000010000010000" },
+        { 'A', "010101111101101" }, { 'C', "111100100100111" }, { 'D', "110101101101110" },
+        { 'F', "111100110100100" }, { 'L', "100100100100111" }, { 'M', "101111111101101" },
+        { 'P', "110101110100100" }, { 'R', "110101110101101" }, { 'S', "111100111001111" },
+        { 'W', "101101111111101" }, { 'X', "101101010101101" },
+    };
+
+    const char* glyphRows(char c) {
+        for (const Glyph& glyph : font) {
+            if (glyph.c == c) {
+                return glyph.rows;
+            }
+        }
+        return nullptr; // Spaces and anything unknown are left blank
+    }
+
+    const SDL_Color PANEL = { 0, 0, 0, 170 };
+    const SDL_Color TEXT = { 255, 255, 255, 255 };
+    const SDL_Color GOOD = { 90, 220, 90, 255 };
+    const SDL_Color SLOW = { 230, 80, 60, 255 };
+}
+
+// Constructor
+
+ProfilerOverlay::ProfilerOverlay(int x, int y, int scale) : solid({ 0, 0, 0, 0 }), visible(false), x(x), y(y), scale(scale) {
+}
+
+void ProfilerOverlay::toggle() {
+    visible = !visible;
+}
+
+bool ProfilerOverlay::isVisible() const {
+    return visible;
+}
+
+// Drawing
+
+void ProfilerOverlay::addRect(const SDL_Rect& rect, SDL_Color color) {
+    batch.addQuad(rect, solid, color);
+}
+
+void ProfilerOverlay::addText(const std::string& text, int textX, int textY, SDL_Color color) {
+    for (char c : text) {
+        const char* rows = glyphRows(c);
+        for (int i = 0; rows && i < 15; i++) {
+            if (rows[i] == '1') {
+                addRect({ textX + (i % 3) * scale, textY + (i / 3) * scale, scale, scale }, color);
+            }
+        }
+        textX += 4 * scale;
+    }
+}
+
+void ProfilerOverlay::render(SDL_Renderer* renderer, const TextureAtlas& atlas) {
+    if (!visible) {
+        return;
+    }
+    profiler::FrameStats stats = profiler::getFrameStats();
+    char lines[6][32];
+    std::snprintf(lines[0], sizeof(lines[0]), "FPS %.0f", stats.fps);
+    std::snprintf(lines[1], sizeof(lines[1]), "P50 %.2f MS", stats.p50);
+    std::snprintf(lines[2], sizeof(lines[2]), "P95 %.2f MS", stats.p95);
+    std::snprintf(lines[3], sizeof(lines[3]), "P99 %.2f MS", stats.p99);
+    std::snprintf(lines[4], sizeof(lines[4]), "MAX %.2f MS", stats.max);
+    std::snprintf(lines[5], sizeof(lines[5]), "DRAW CALLS %u", unsigned(stats.drawCalls));
+
+    int lineHeight = 7 * scale;
+    int graphHeight = 20 * scale;
+    int width = OVERLAY_GRAPH_FRAMES * 2 + 4 * scale;
+    int height = 6 * lineHeight + graphHeight + 4 * scale;
+
+    batch.begin(atlas.getTexture());
+    solid = atlas.getSolidCell();
+    addRect({ x, y, width, height }, PANEL);
+    for (int i = 0; i < 6; i++) {
+        addText(lines[i], x + 2 * scale, y + 2 * scale + i * lineHeight, TEXT);
+    }
+
+    // One bar per frame, red once a frame misses 60 Hz
+    float times[OVERLAY_GRAPH_FRAMES];
+    int count = profiler::getFrameTimes(times, OVERLAY_GRAPH_FRAMES);
+    int graphBottom = y + height - 2 * scale;
+    for (int i = 0; i < count; i++) {
+        int h = std::max(1, int(std::min(times[i] / OVERLAY_GRAPH_MS, 1.0f) * graphHeight));
+        addRect({ x + 2 * scale + i * 2, graphBottom - h, 2, h }, times[i] > 16.7f ? SLOW : GOOD);
+    }
+    batch.flush(renderer);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <SDL.h>
+#include <string>
+#include "Profiler.h"
+#include "RenderBatch.h"
+#include "TextureAtlas.h"
+
+#define OVERLAY_GRAPH_FRAMES 120
+#define OVERLAY_GRAPH_MS 33.3f // Frame time that fills the graph height
+
+// On-screen frame statistics: FPS, frame-time percentiles, draw calls and a graph of the
+// last frames. Text uses a built-in 3x5 pixel font and everything is flat quads from the
+// atlas's white cell, so the overlay costs a single extra draw call.
+
+class ProfilerOverlay {
+    RenderBatch batch;
+    SDL_Rect solid; // The atlas's white cell
+    bool visible;
+    int x;
+    int y;
+    int scale; // Screen pixels per font pixel
+
+    void addRect(const SDL_Rect& rect, SDL_Color color);
+    void addText(const std::string& text, int textX, int textY, SDL_Color color);
+public:
+    ProfilerOverlay(int x, int y, int scale = 2);
+
+    void toggle();
+    bool isVisible() const;
+
+    void render(SDL_Renderer* renderer, const TextureAtlas& atlas);
+};
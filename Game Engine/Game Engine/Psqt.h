@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "Bitboard.h"
+
+// ======================
+// Piece-square tables, generated at compile time
+// ======================
+// Midgame and endgame values are packed into one 32-bit Score (endgame in the high half),
+// so a single add updates both halves. Material is folded into the tables and the sums
+// are kept up to date by Position on every piece placement.
+
+typedef int32_t Score;
+
+constexpr Score makeScore(int mg, int eg) {
+    return Score(uint32_t(eg) << 16) + mg;
+}
+
+// Rounding the high half keeps negative midgame values from borrowing from the endgame
+constexpr int egValue(Score s) {
+    return int16_t(uint16_t(uint32_t(s + 0x8000) >> 16));
+}
+
+constexpr int mgValue(Score s) {
+    return int16_t(uint16_t(uint32_t(s)));
+}
+
+#define PHASE_MAX 24 // Game phase of the starting material, 0 is a bare endgame
+
+namespace psqt {
+
+    constexpr int MATERIAL_MG[PIECE_TYPE_NB] = { 82, 337, 365, 477, 1025, 0 };
+    constexpr int MATERIAL_EG[PIECE_TYPE_NB] = { 94, 281, 297, 512, 936, 0 };
+    constexpr int PHASE_WEIGHTS[PIECE_TYPE_NB] = { 0, 1, 1, 2, 4, 0 };
+
+    constexpr int abs(int v) {
+        return v < 0 ? -v : v;
+    }
+
+    // Positional bonus of a white piece, file and rank seen from white
+    constexpr Score bonus(PieceType pt, int file, int rank) {
+        int fc = file < 4 ? file : 7 - file; // 0 on the rim, 3 in the center
+        int rc = rank < 4 ? rank : 7 - rank;
+        int center = fc + rc;
+        switch (pt) {
+        case PAWN: {
+            if (rank == 0 || rank == 7) {
+                return 0;
+            }
+            int mg = (rank - 1) * 5 + (fc == 3 ? (rank >= 3 ? 20 : 5) : fc == 2 ? 5 : 0);
+            return makeScore(mg, (rank - 1) * 10);
+        }
+        case KNIGHT:
+            return makeScore(center * 8 - 24, center * 6 - 18);
+        case BISHOP:
+            return makeScore(center * 4 - 12 - (rank == 0 ? 10 : 0), center * 4 - 12);
+        case ROOK:
+            return makeScore((rank == 6 ? 20 : 0) + (fc == 3 ? 5 : 0), rank == 6 ? 10 : 0);
+        case QUEEN:
+            return makeScore(center * 2 - 6, center * 5 - 15);
+        default: {
+            // Tucked away behind its pawns early, walking to the center late
+            constexpr int backRank[8] = { 20, 30, 10, 0, 0, 10, 30, 20 };
+            int mg = rank == 0 ? backRank[file] : rank == 1 ? -10 : -20 - 10 * rank;
+            return makeScore(mg, center * 10 - 30);
+        }
+        }
+    }
+
+    // Indexed by piece code, black entries are white's mirrored and negated so sums are white relative
+    constexpr std::array<std::array<Score, 64>, 12> makeTable() {
+        std::array<std::array<Score, 64>, 12> table{};
+        for (int pt = PAWN; pt < PIECE_TYPE_NB; pt++) {
+            for (int sq = 0; sq < 64; sq++) {
+                Score s = makeScore(MATERIAL_MG[pt], MATERIAL_EG[pt]) + bonus(PieceType(pt), fileOf(sq), rankOf(sq));
+                table[makePiece(WHITE, PieceType(pt))][sq] = s;
+                table[makePiece(BLACK, PieceType(pt))][sq ^ 56] = -s;
+            }
+        }
+        return table;
+    }
+
+    inline constexpr std::array<std::array<Score, 64>, 12> TABLE = makeTable();
+
+    inline Score value(PieceCode pc, int sq) {
+        return TABLE[pc][sq];
+    }
+
+    inline int phase(PieceCode pc) {
+        return PHASE_WEIGHTS[typeOf(pc)];
+    }
+}
@@ -0,0 +1,57 @@
+#include "RenderBatch.h"
+#include "Helpers.h"
+
+// Constructor
+
+RenderBatch::RenderBatch() : texture(nullptr), texelW(0), texelH(0) {
+}
+
+// Batching
+
+void RenderBatch::begin(SDL_Texture* texture) {
+    this->texture = texture;
+    vertices.clear();
+    indices.clear();
+
+    int w = 1;
+    int h = 1;
+    SDL_QueryTexture(texture, nullptr, nullptr, &w, &h);
+    texelW = 1.0f / w;
+    texelH = 1.0f / h;
+}
+
+void RenderBatch::addQuad(const SDL_Rect& dst, const SDL_Rect& src, SDL_Color color) {
+    int base = int(vertices.size());
+    float x0 = float(dst.x);
+    float y0 = float(dst.y);
+    float x1 = float(dst.x + dst.w);
+    float y1 = float(dst.y + dst.h);
+    float u0 = src.x * texelW;
+    float v0 = src.y * texelH;
+    float u1 = (src.x + src.w) * texelW;
+    float v1 = (src.y + src.h) * texelH;
+
+    vertices.push_back({ { x0, y0 }, color, { u0, v0 } });
+    vertices.push_back({ { x1, y0 }, color, { u1, v0 } });
+    vertices.push_back({ { x1, y1 }, color, { u1, v1 } });
+    vertices.push_back({ { x0, y1 }, color, { u0, v1 } });
+
+    const int corners[6] = { 0, 1, 2, 0, 2, 3 };
+    for (int corner : corners) {
+        indices.push_back(base + corner);
+    }
+}
+
+void RenderBatch::flush(SDL_Renderer* renderer) {
+    if (indices.empty()) {
+        return;
+    }
+    SDL_RenderGeometry(renderer, texture, vertices.data(), int(vertices.size()), indices.data(), int(indices.size()));
+    helpers::countDrawCall();
+    vertices.clear();
+    indices.clear();
+}
+
+int RenderBatch::getQuadCount() const {
+    return int(vertices.size() / 4);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <SDL.h>
+#include <vector>
+
+// Collects textured quads from one texture and submits them in a single
+// SDL_RenderGeometry call. The vertex storage is reused from frame to frame.
+
+class RenderBatch {
+    SDL_Texture* texture;
+    float texelW;
+    float texelH;
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+public:
+    RenderBatch();
+
+    // Starts a new batch drawing from the texture
+    void begin(SDL_Texture* texture);
+
+    // Queues the src part of the texture to dst, modulated by color
+    void addQuad(const SDL_Rect& dst, const SDL_Rect& src, SDL_Color color = { 255, 255, 255, 255 });
+
+    // Draws everything queued since begin() with one draw call
+    void flush(SDL_Renderer* renderer);
+
+    int getQuadCount() const;
+};
@@ -0,0 +1,146 @@
+#include <SDL.h>
+#include <SDL_image.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Helpers.h"
+#include "Board.h"
+
+// Headless render benchmark, draws scripted board states with SDL's software renderer
+//   render_bench [--width W] [--height H] [--board-size S] [--frames N]
+//                [--snapshot-every K] [--snapshot-dir DIR] [--assets DIR]
+// Every frame plays the next move of a fixed game, so pieces, captures and castling all
+// show up. With --snapshot-every, every K-th frame is saved as frame_NNNNN.png for pixel
+// comparison between builds.
+
+namespace {
+    // Ruy Lopez, closed variation
+    const std::vector<std::string> SCRIPT = {
+        "e2e4", "e7e5", "g1f3", "b8c6", "f1b5", "a7a6", "b5a4", "g8f6", "e1g1", "f8e7",
+        "f1e1", "b7b5", "a4b3", "d7d6", "c2c3", "e8g8", "h2h3", "c6a5", "b3c2", "c7c5",
+        "d2d4", "d8c7", "b1d2", "c5d4", "c3d4", "a5c6", "d2b3", "a6a5", "c1e3", "a5a4",
+    };
+
+    const SDL_Color LIGHT = { 255, 204, 114, 255 };
+    const SDL_Color DARK = { 70, 47, 8, 255 };
+
+    void printUsage() {
+        std::cout << "Usage: render_bench [--width W] [--height H] [--board-size S] [--frames N]"
+            " [--snapshot-every K] [--snapshot-dir DIR] [--assets DIR]" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int width = 800;
+    int height = 800;
+    int boardSize = 100;
+    int frames = 1000;
+    int snapshotEvery = 0;
+    std::string snapshotDir = ".";
+    std::string assets = PIECE_ASSET_DIR;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--width") && i + 1 < argc) {
+            width = std::stoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--height") && i + 1 < argc) {
+            height = std::stoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--board-size") && i + 1 < argc) {
+            boardSize = std::stoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--frames") && i + 1 < argc) {
+            frames = std::stoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--snapshot-every") && i + 1 < argc) {
+            snapshotEvery = std::stoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--snapshot-dir") && i + 1 < argc) {
+            snapshotDir = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--assets") && i + 1 < argc) {
+            assets = argv[++i];
+        }
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (width <= 0 || height <= 0 || width > 0xFFFF || height > 0xFFFF || boardSize <= 0 || boardSize > 0xFFFF / 8 || frames <= 0) {
+        printUsage();
+        return 1;
+    }
+
+    SDL_Renderer* renderer;
+    SDL_Surface* target;
+    if (helpers::initHeadless(renderer, target, width, height)) {
+        return 1;
+    }
+
+    Piece::renderer = renderer;
+    Piece::board_xsp = 0;
+    Piece::board_ysp = 0;
+    Piece::board_size = boardSize;
+    try {
+        Piece::atlas = new TextureAtlas(renderer, assets);
+    }
+    catch (const std::exception& e) {
+        std::cout << e.what() << std::endl;
+        helpers::quit();
+        return 1;
+    }
+
+    uint64_t drawCalls = 0;
+    double elapsed = 0;
+    int snapshots = 0;
+    {
+        Board b(boardSize, 0, 0);
+        size_t ply = 0;
+        for (int frame = 0; frame < frames; frame++) {
+            // Next scripted state, the game starts over once the script runs out
+            if (ply == SCRIPT.size()) {
+                b.setPosition(START_FEN);
+                ply = 0;
+            }
+            else {
+                b.applyEngineMove(parseUciMove(b.getPosition(), SCRIPT[ply++]), b.getPosition().getKey());
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            helpers::resetDrawCalls();
+            SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+            SDL_RenderClear(renderer);
+            helpers::countDrawCall();
+            b.render_board(renderer, LIGHT, DARK);
+            b.render_pieces();
+            SDL_RenderPresent(renderer);
+            b.clearDirty();
+            elapsed += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            drawCalls += helpers::getDrawCalls();
+
+            // Snapshots are written outside the timed part
+            if (snapshotEvery && frame % snapshotEvery == 0) {
+                char name[32];
+                std::snprintf(name, sizeof(name), "/frame_%05d.png", frame);
+                snapshots += helpers::savePNG(target, snapshotDir + name);
+            }
+        }
+    }
+
+    std::cout << "frames " << frames << "  size " << width << "x" << height << "  board " << boardSize * 8 << "px" << std::endl;
+    std::cout << "time " << std::fixed << std::setprecision(3) << elapsed << "s"
+        << "  fps " << std::setprecision(1) << frames / elapsed
+        << "  ms/frame " << std::setprecision(3) << 1000 * elapsed / frames
+        << "  draw calls/frame " << std::setprecision(1) << double(drawCalls) / frames << std::endl;
+    if (snapshotEvery) {
+        std::cout << snapshots << " snapshots written to " << snapshotDir << std::endl;
+    }
+
+    delete Piece::atlas;
+    Piece::atlas = nullptr;
+    helpers::quit();
+    return 0;
+}
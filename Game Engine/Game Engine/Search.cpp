@@ -0,0 +1,615 @@
+#include "Search.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include "MovePicker.h"
+#include "Tablebase.h"
+
+namespace {
+    int lmrTable[64][64];
+
+    // Late move reductions grow with both the remaining depth and the move number
+    void initLmr() {
+        for (int d = 1; d < 64; d++) {
+            for (int m = 1; m < 64; m++) {
+                lmrTable[d][m] = int(0.75 + std::log(d) * std::log(m) / 2.25);
+            }
+        }
+    }
+
+    // Mate and tablebase scores are stored relative to the node so they stay valid at other plies
+    int scoreToTT(int score, int ply) {
+        return score >= TB_BOUND ? score + ply : score <= -TB_BOUND ? score - ply : score;
+    }
+
+    int scoreFromTT(int score, int ply) {
+        return score >= TB_BOUND ? score - ply : score <= -TB_BOUND ? score + ply : score;
+    }
+
+    // Cursed wins and blessed losses stay next to the draw score
+    int scoreFromWdl(tablebase::Wdl wdl, int ply) {
+        return wdl == tablebase::WDL_WIN ? TB_WIN_SCORE - ply : wdl == tablebase::WDL_LOSS ? -TB_WIN_SCORE + ply : int(wdl);
+    }
+
+    constexpr int HISTORY_MAX = 16384;
+}
+
+namespace {
+    // Depth staggering for helper threads: thread i skips blocks of SKIP_SIZE depths
+    // at its own phase, so the helpers spread over different iterations
+    constexpr int SKIP_SIZE[20] = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+    constexpr int SKIP_PHASE[20] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+}
+
+// ======================
+// Search, the thread coordinator
+// ======================
+
+Search::Search(TranspositionTable& tt, int threadCount) : tt(tt), rootInTablebase(false), rootTbScore(0), stopRequested(false), stopped(false), pondering(false), softLimitMs(0), hardLimitMs(0) {
+    static bool lmrReady = false;
+    if (!lmrReady) {
+        initLmr();
+        lmrReady = true;
+    }
+    setThreads(threadCount);
+}
+
+void Search::setThreads(int count) {
+    count = std::clamp(count, 1, MAX_THREADS);
+    threads.clear();
+    for (int i = 0; i < count; i++) {
+        threads.push_back(std::make_unique<SearchThread>(*this, i));
+    }
+}
+
+int Search::getThreads() const {
+    return int(threads.size());
+}
+
+uint64_t Search::getNodes() const {
+    uint64_t total = 0;
+    for (const auto& thread : threads) {
+        total += thread->nodes.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t Search::getTbHits() const {
+    uint64_t total = 0;
+    for (const auto& thread : threads) {
+        total += thread->tbHits.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+double Search::getPawnHitRate() const {
+    uint64_t probes = 0;
+    uint64_t hits = 0;
+    for (const auto& thread : threads) {
+        probes += thread->pawnTable.getProbes();
+        hits += thread->pawnTable.getHits();
+    }
+    return probes ? double(hits) / probes : 0;
+}
+
+double Search::getFirstMoveCutoffRate() const {
+    uint64_t cutoffs = 0;
+    uint64_t first = 0;
+    for (const auto& thread : threads) {
+        cutoffs += thread->cutoffs;
+        first += thread->firstMoveCutoffs;
+    }
+    return cutoffs ? double(first) / cutoffs : 0;
+}
+
+void Search::clearHistory() {
+    for (auto& thread : threads) {
+        thread->clearHistory();
+    }
+}
+
+void Search::setInfoCallback(std::function<void(const SearchInfo&)> callback) {
+    infoCallback = callback;
+}
+
+const SearchInfo& Search::getLastInfo() const {
+    return lastInfo;
+}
+
+void Search::stop() {
+    stopRequested = true;
+}
+
+void Search::clearStop() {
+    stopRequested = false;
+}
+
+void Search::setPondering(bool value) {
+    pondering = value;
+}
+
+void Search::ponderHit() {
+    pondering = false;
+}
+
+// Time management
+
+void Search::initTimeLimits(Color us) {
+    softLimitMs = hardLimitMs = 0;
+    if (limits.infinite) {
+        return;
+    }
+
+    if (limits.movetime) {
+        softLimitMs = hardLimitMs = limits.movetime;
+    }
+    else if (limits.time[us]) {
+        // Spread the clock over the remaining moves, keep a margin for overhead
+        int movesToGo = limits.movesToGo ? limits.movesToGo : 30;
+        int64_t available = std::max(1, limits.time[us] - 20);
+        softLimitMs = available / movesToGo + limits.increment[us] * 3 / 4;
+        hardLimitMs = std::min(available / 2, softLimitMs * 4);
+        softLimitMs = std::min(softLimitMs, hardLimitMs);
+    }
+}
+
+int64_t Search::elapsedMs() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+// Only the main thread looks at the clock and the node budget
+void Search::checkLimits() {
+    if (stopRequested || (!pondering && hardLimitMs && elapsedMs() >= hardLimitMs) || (limits.nodes && getNodes() >= limits.nodes)) {
+        stopped = true;
+    }
+}
+
+void Search::reportIteration(const SearchThread& thread) {
+    lastInfo.depth = thread.completedDepth;
+    lastInfo.selDepth = thread.selDepth;
+    // The evaluation cannot tell a tablebase win from a long one, a mate found is still shown
+    lastInfo.score = rootInTablebase && std::abs(thread.bestScore) < MATE_BOUND ? rootTbScore : thread.bestScore;
+    lastInfo.nodes = getNodes();
+    lastInfo.tbHits = getTbHits();
+    lastInfo.timeMs = elapsedMs();
+    lastInfo.pv = thread.bestPv;
+    if (infoCallback) {
+        infoCallback(lastInfo);
+    }
+}
+
+Move Search::think(const Position& root, const SearchLimits& searchLimits) {
+    limits = searchLimits;
+    startTime = std::chrono::steady_clock::now();
+    stopped = false;
+    lastInfo = SearchInfo();
+    initTimeLimits(root.getSideToMove());
+    tt.newSearch();
+
+    Position rootCopy = root;
+    rootMoves.clear();
+    generateMoves(rootCopy, rootMoves);
+    if (rootMoves.empty()) {
+        stopRequested = false;
+        return Move();
+    }
+    // In a tablebase position only the moves keeping the result are searched, the search
+    // then picks the way to convert it and the table gives the score
+    tablebase::Wdl rootWdl;
+    rootInTablebase = tablebase::filterRootMoves(rootCopy, rootMoves) && tablebase::probeWdl(rootCopy, rootWdl);
+    rootTbScore = rootInTablebase ? scoreFromWdl(rootWdl, 0) : 0;
+
+    for (auto& thread : threads) {
+        thread->position = root;
+        thread->nodes = 0;
+        thread->tbHits = 0;
+        thread->pawnTable.resetStats();
+        thread->cutoffs = 0;
+        thread->firstMoveCutoffs = 0;
+        thread->completedDepth = 0;
+        thread->bestScore = -INFINITE_SCORE;
+        thread->bestPv.clear();
+    }
+
+    // Helpers run on their own threads, the main thread searches on the caller's
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < threads.size(); i++) {
+        workers.emplace_back(&SearchThread::iterativeDeepening, threads[i].get());
+    }
+    threads[0]->iterativeDeepening();
+
+    // An infinite or pondering search keeps its answer until it is told to stop
+    while ((limits.infinite || pondering) && !stopRequested) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    stopped = true;
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    // Trust a helper over the main thread only if it finished a deeper iteration at least as well
+    const SearchThread* best = threads[0].get();
+    for (const auto& thread : threads) {
+        if (!thread->bestPv.empty() && thread->completedDepth > best->completedDepth && thread->bestScore >= best->bestScore) {
+            best = thread.get();
+        }
+    }
+    if (best != threads[0].get()) {
+        reportIteration(*best);
+    }
+
+    lastInfo.nodes = getNodes();
+    lastInfo.tbHits = getTbHits();
+    lastInfo.timeMs = elapsedMs();
+    stopRequested = false;
+    pondering = false;
+    return best->bestPv.empty() ? rootMoves[0] : best->bestPv[0];
+}
+
+// ======================
+// SearchThread
+// ======================
+
+SearchThread::SearchThread(Search& search, int id) : search(search), id(id), nodes(0), tbHits(0), selDepth(0), cutoffs(0), firstMoveCutoffs(0), completedDepth(0), bestScore(0) {
+    clearHistory();
+}
+
+void SearchThread::clearHistory() {
+    for (auto& k : killers) {
+        k[0] = k[1] = Move();
+    }
+    for (auto& side : history) {
+        for (auto& from : side) {
+            for (int& h : from) {
+                h = 0;
+            }
+        }
+    }
+    for (auto& piece : counterMoves) {
+        for (Move& move : piece) {
+            move = Move();
+        }
+    }
+}
+
+bool SearchThread::shouldSkipDepth(int depth) const {
+    if (isMain()) {
+        return false;
+    }
+    int i = (id - 1) % 20;
+    return ((depth + SKIP_PHASE[i]) / SKIP_SIZE[i]) % 2;
+}
+
+// Counts a node, the main thread polls the limits every 1024 of its nodes
+bool SearchThread::pollStop() {
+    uint64_t n = nodes.load(std::memory_order_relaxed) + 1;
+    nodes.store(n, std::memory_order_relaxed);
+    if (isMain() && (n & 1023) == 0) {
+        search.checkLimits();
+    }
+    return search.stopped.load(std::memory_order_relaxed);
+}
+
+// Iterative deepening driver
+
+void SearchThread::iterativeDeepening() {
+    int previousScore = 0;
+    int maxDepth = std::min(search.limits.depth, MAX_PLY - 1);
+    for (int depth = 1; depth <= maxDepth; depth++) {
+        if (shouldSkipDepth(depth)) {
+            continue;
+        }
+
+        selDepth = 0;
+        int window = 25;
+        int alpha = -INFINITE_SCORE;
+        int beta = INFINITE_SCORE;
+        if (depth >= 5) {
+            alpha = std::max(previousScore - window, -INFINITE_SCORE);
+            beta = std::min(previousScore + window, INFINITE_SCORE);
+        }
+
+        // Aspiration loop, the window widens on every fail
+        int score;
+        while (true) {
+            score = negamax(alpha, beta, depth, 0, false);
+            if (search.stopped) {
+                break;
+            }
+            if (score <= alpha) {
+                beta = (alpha + beta) / 2;
+                alpha = std::max(score - window, -INFINITE_SCORE);
+            }
+            else if (score >= beta) {
+                beta = std::min(score + window, INFINITE_SCORE);
+            }
+            else {
+                break;
+            }
+            window *= 2;
+        }
+
+        // A partial iteration is thrown away, its root move may be unproven
+        if (search.stopped) {
+            break;
+        }
+
+        previousScore = score;
+        completedDepth = depth;
+        bestScore = score;
+        bestPv.assign(pvTable[0], pvTable[0] + pvLength[0]);
+
+        if (isMain()) {
+            search.reportIteration(*this);
+            if (!search.pondering && search.softLimitMs && search.elapsedMs() >= search.softLimitMs) {
+                break;
+            }
+            // A mate found within the searched depth cannot change any more
+            if (!search.limits.infinite && !search.pondering && std::abs(score) >= MATE_BOUND && depth >= MATE_SCORE - std::abs(score)) {
+                break;
+            }
+        }
+    }
+}
+
+// Move ordering
+
+// Slot of the opponent's last move in the counter-move table, null after a null move
+Move SearchThread::counterMove() const {
+    Move last = position.getLastMove();
+    return last.isNull() ? Move() : counterMoves[position.pieceOn(last.getTo())][last.getTo()];
+}
+
+void SearchThread::updateQuietStats(Move best, const Move* quiets, int quietCount, int depth, int ply) {
+    if (killers[ply][0] != best) {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = best;
+    }
+    Move last = position.getLastMove();
+    if (!last.isNull()) {
+        counterMoves[position.pieceOn(last.getTo())][last.getTo()] = best;
+    }
+
+    // History with gravity, the bonus shrinks as the entry saturates
+    Color us = position.getSideToMove();
+    int bonus = std::min(depth * depth, 400);
+    auto update = [&](Move move, int delta) {
+        int& h = history[us][move.getFrom()][move.getTo()];
+        h += delta - h * std::abs(delta) / HISTORY_MAX;
+    };
+    update(best, bonus);
+    for (int i = 0; i < quietCount; i++) {
+        if (quiets[i] != best) {
+            update(quiets[i], -bonus);
+        }
+    }
+}
+
+// Main search
+
+int SearchThread::negamax(int alpha, int beta, int depth, int ply, bool nullAllowed) {
+    bool pvNode = beta - alpha > 1;
+    pvLength[ply] = ply;
+
+    if (depth <= 0) {
+        return quiescence(alpha, beta, ply);
+    }
+
+    if (pollStop()) {
+        return 0;
+    }
+    selDepth = std::max(selDepth, ply);
+
+    if (ply > 0) {
+        if (position.isDraw()) {
+            return 0;
+        }
+        if (ply >= MAX_PLY - 1) {
+            return eval::evaluate(position, &pawnTable);
+        }
+
+        // Mate distance pruning, no line can beat a mate already found closer to the root
+        alpha = std::max(alpha, -MATE_SCORE + ply);
+        beta = std::min(beta, MATE_SCORE - ply - 1);
+        if (alpha >= beta) {
+            return alpha;
+        }
+    }
+
+    uint64_t key = position.getKey();
+    TTData ttData;
+    bool ttHit = search.tt.probe(key, ttData);
+    Move ttMove = ttHit ? ttData.move : Move();
+    if (ttHit && !pvNode && ttData.depth >= depth) {
+        int ttScore = scoreFromTT(ttData.score, ply);
+        if (ttData.bound == BOUND_EXACT
+            || (ttData.bound == BOUND_LOWER && ttScore >= beta)
+            || (ttData.bound == BOUND_UPPER && ttScore <= alpha)) {
+            return ttScore;
+        }
+    }
+
+    // Tablebase probe, right after a capture or pawn move: the table's result assumes a fresh
+    // fifty-move counter. Wins and losses only bound the score, the search may still find the mate.
+    if (ply > 0 && position.getHalfmoveClock() == 0 && !position.getCastlingRights()
+        && popcount(position.getOccupied()) <= tablebase::getMaxPieces()) {
+        tablebase::Wdl wdl;
+        if (tablebase::probeWdl(position, wdl)) {
+            tbHits.store(tbHits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            int score = scoreFromWdl(wdl, ply);
+            Bound bound = wdl == tablebase::WDL_WIN ? BOUND_LOWER : wdl == tablebase::WDL_LOSS ? BOUND_UPPER : BOUND_EXACT;
+            if (bound == BOUND_EXACT || (bound == BOUND_LOWER && score >= beta) || (bound == BOUND_UPPER && score <= alpha)) {
+                int eval = ttHit ? ttData.eval : eval::evaluate(position, &pawnTable);
+                search.tt.store(key, Move(), scoreToTT(score, ply), eval, std::min(depth + 6, MAX_PLY - 1), bound);
+                return score;
+            }
+        }
+    }
+
+    bool inCheck = position.isInCheck();
+    if (inCheck) {
+        depth++;
+    }
+    int staticEval = inCheck ? -INFINITE_SCORE : ttHit ? ttData.eval : eval::evaluate(position, &pawnTable);
+
+    // Null move pruning: if passing still beats beta, a real move will too
+    Color us = position.getSideToMove();
+    if (!pvNode && !inCheck && nullAllowed && depth >= 3 && staticEval >= beta && position.hasNonPawnMaterial(us)) {
+        int reduction = 3 + depth / 6;
+        position.makeNullMove();
+        int score = -negamax(-beta, -beta + 1, depth - 1 - reduction, ply + 1, false);
+        position.unmakeNullMove();
+        if (search.stopped.load(std::memory_order_relaxed)) {
+            return 0;
+        }
+        if (score >= beta) {
+            return score >= TB_BOUND ? beta : score;
+        }
+    }
+
+    // Later stages are only generated if the earlier moves do not cut off
+    MovePicker picker = ply == 0
+        ? MovePicker(position, search.rootMoves, ttMove, killers[ply], counterMove(), history[us])
+        : MovePicker(position, ttMove, killers[ply], counterMove(), history[us]);
+
+    Move quiets[MAX_MOVES];
+    int quietCount = 0;
+    int originalAlpha = alpha;
+    int bestScore = -INFINITE_SCORE;
+    Move bestMove;
+
+    int moveCount = 0;
+    for (Move move = picker.next(); !move.isNull(); move = picker.next()) {
+        int i = moveCount++;
+        bool quiet = !move.isCapture() && !move.isPromotion();
+
+        position.makeMove(move);
+        // The child probes the table early on, start loading its entry now
+        search.tt.prefetch(position.getKey());
+        bool givesCheck = position.isInCheck();
+        int newDepth = depth - 1;
+        int score;
+
+        if (i == 0) {
+            score = -negamax(-beta, -alpha, newDepth, ply + 1, true);
+        }
+        else {
+            // Late quiet moves are searched shallower first and only re-searched if they surprise
+            int reduction = 0;
+            if (depth >= 3 && i >= 3 && quiet && !inCheck && !givesCheck) {
+                reduction = lmrTable[std::min(depth, 63)][std::min(i, 63)];
+                reduction -= pvNode;
+                reduction -= move == killers[ply][0] || move == killers[ply][1];
+                reduction = std::clamp(reduction, 0, newDepth - 1);
+            }
+
+            // Principal variation search: prove the move is worse with a null window
+            score = -negamax(-alpha - 1, -alpha, newDepth - reduction, ply + 1, true);
+            if (score > alpha && reduction > 0) {
+                score = -negamax(-alpha - 1, -alpha, newDepth, ply + 1, true);
+            }
+            if (score > alpha && score < beta) {
+                score = -negamax(-beta, -alpha, newDepth, ply + 1, true);
+            }
+        }
+        position.unmakeMove();
+
+        if (search.stopped.load(std::memory_order_relaxed)) {
+            return 0;
+        }
+
+        if (score > bestScore) {
+            bestScore = score;
+            bestMove = move;
+            if (score > alpha) {
+                alpha = score;
+                pvTable[ply][ply] = move;
+                for (int j = ply + 1; j < pvLength[ply + 1]; j++) {
+                    pvTable[ply][j] = pvTable[ply + 1][j];
+                }
+                pvLength[ply] = std::max(pvLength[ply + 1], ply + 1);
+
+                if (score >= beta) {
+                    cutoffs++;
+                    firstMoveCutoffs += i == 0;
+                    if (quiet) {
+                        updateQuietStats(move, quiets, quietCount, depth, ply);
+                    }
+                    break;
+                }
+            }
+        }
+        if (quiet) {
+            quiets[quietCount++] = move;
+        }
+    }
+    if (!moveCount) {
+        return inCheck ? -MATE_SCORE + ply : 0;
+    }
+
+    Bound bound = bestScore >= beta ? BOUND_LOWER : alpha > originalAlpha ? BOUND_EXACT : BOUND_UPPER;
+    search.tt.store(key, bestMove, scoreToTT(bestScore, ply), inCheck ? 0 : staticEval, depth, bound);
+    return bestScore;
+}
+
+// Quiescence search, resolves captures so the static eval is taken on a quiet board
+
+int SearchThread::quiescence(int alpha, int beta, int ply) {
+    pvLength[ply] = ply;
+    if (pollStop()) {
+        return 0;
+    }
+    selDepth = std::max(selDepth, ply);
+
+    if (position.isDraw()) {
+        return 0;
+    }
+    if (ply >= MAX_PLY - 1) {
+        return eval::evaluate(position, &pawnTable);
+    }
+
+    // In check every evasion is searched, otherwise the side to move may stand pat
+    bool inCheck = position.isInCheck();
+    int bestScore = -INFINITE_SCORE;
+    if (!inCheck) {
+        bestScore = eval::evaluate(position, &pawnTable);
+        if (bestScore >= beta) {
+            return bestScore;
+        }
+        alpha = std::max(alpha, bestScore);
+    }
+
+    // Out of check only promotions and captures that do not lose material are handed out
+    MovePicker picker = inCheck
+        ? MovePicker(position, Move(), killers[ply], counterMove(), history[position.getSideToMove()])
+        : MovePicker(position);
+
+    int moveCount = 0;
+    for (Move move = picker.next(); !move.isNull(); move = picker.next()) {
+        moveCount++;
+        if (!inCheck && !move.isCapture() && !(move.isPromotion() && move.getPromotion() == QUEEN)) {
+            continue;
+        }
+
+        position.makeMove(move);
+        int score = -quiescence(-beta, -alpha, ply + 1);
+        position.unmakeMove();
+
+        if (search.stopped.load(std::memory_order_relaxed)) {
+            return 0;
+        }
+        if (score > bestScore) {
+            bestScore = score;
+            if (score > alpha) {
+                alpha = score;
+                if (score >= beta) {
+                    break;
+                }
+            }
+        }
+    }
+    if (inCheck && !moveCount) {
+        return -MATE_SCORE + ply;
+    }
+    return bestScore;
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "Position.h"
+#include "MoveGen.h"
+#include "TranspositionTable.h"
+#include "Evaluation.h"
+
+#define MAX_PLY 128
+#define MAX_THREADS 256
+#define INFINITE_SCORE 32001
+#define MATE_SCORE 32000
+#define MATE_BOUND (MATE_SCORE - MAX_PLY) // Scores beyond this are mates
+#define TB_WIN_SCORE (MATE_BOUND - 1) // Tablebase win at the root, minus the ply it was found at
+#define TB_BOUND (TB_WIN_SCORE - MAX_PLY) // Scores beyond this are tablebase wins or mates
+
+// What the search may spend, zero means no limit. Clock times are in milliseconds.
+struct SearchLimits {
+    int depth = MAX_PLY - 1;
+    uint64_t nodes = 0;
+    int movetime = 0;
+    int time[COLOR_NB] = { 0, 0 };
+    int increment[COLOR_NB] = { 0, 0 };
+    int movesToGo = 0;
+    bool infinite = false;
+};
+
+// Snapshot reported after every completed iteration
+struct SearchInfo {
+    int depth = 0;
+    int selDepth = 0;
+    int score = 0;
+    uint64_t nodes = 0;
+    uint64_t tbHits = 0;
+    int64_t timeMs = 0;
+    std::vector<Move> pv;
+};
+
+class Search;
+
+// One search thread. Every thread owns its position, killers, history and PV so the
+// only state shared between threads is the transposition table and the stop flag.
+
+class SearchThread {
+    friend class Search;
+
+    Search& search;
+    int id;
+    Position position;
+    PawnTable pawnTable;
+
+    std::atomic<uint64_t> nodes;
+    std::atomic<uint64_t> tbHits;
+    int selDepth;
+    uint64_t cutoffs; // Beta cutoffs of the main search, and how many came from the first move
+    uint64_t firstMoveCutoffs;
+
+    Move killers[MAX_PLY][2];
+    int history[COLOR_NB][64][64];
+    Move counterMoves[12][64]; // Quiet move that refuted the last move, by its piece and target
+    Move pvTable[MAX_PLY][MAX_PLY];
+    int pvLength[MAX_PLY];
+
+    // Result of the last completed iteration
+    int completedDepth;
+    int bestScore;
+    std::vector<Move> bestPv;
+
+    bool isMain() const { return id == 0; }
+    bool shouldSkipDepth(int depth) const;
+    void iterativeDeepening();
+
+    int negamax(int alpha, int beta, int depth, int ply, bool nullAllowed);
+    int quiescence(int alpha, int beta, int ply);
+    bool pollStop();
+
+    Move counterMove() const;
+    void updateQuietStats(Move best, const Move* quiets, int quietCount, int depth, int ply);
+public:
+    SearchThread(Search& search, int id);
+
+    void clearHistory();
+};
+
+// Lazy SMP search: negamax alpha-beta with iterative deepening, aspiration windows,
+// principal variation search, null-move pruning, late move reductions and staged move
+// ordering (see MovePicker), run by N threads that only cooperate through the transposition table.
+// Helper threads stagger their iteration depths so they fill the table with other subtrees.
+
+class Search {
+    friend class SearchThread;
+
+    TranspositionTable& tt;
+    std::vector<std::unique_ptr<SearchThread>> threads;
+    SearchLimits limits;
+    MoveList rootMoves; // Legal root moves, only those keeping the tablebase result when the root is in one
+    bool rootInTablebase;
+    int rootTbScore; // Result of a tablebase root, reported instead of the searched score
+
+    std::atomic<bool> stopRequested;
+    std::atomic<bool> stopped;
+    std::atomic<bool> pondering;
+    std::chrono::steady_clock::time_point startTime;
+    int64_t softLimitMs;
+    int64_t hardLimitMs;
+
+    SearchInfo lastInfo;
+    std::function<void(const SearchInfo&)> infoCallback;
+
+    void initTimeLimits(Color us);
+    int64_t elapsedMs() const;
+    void checkLimits();
+    void reportIteration(const SearchThread& thread);
+public:
+    Search(TranspositionTable& tt, int threadCount = 1);
+
+    // Searches the position within the limits and returns the best move found
+    Move think(const Position& root, const SearchLimits& limits);
+
+    // Asks a running search to return as soon as possible, safe to call from another thread.
+    // A stop request outlives the search it hit and is only cleared at the end of think(),
+    // callers racing a search start should clear it themselves before starting.
+    void stop();
+    void clearStop();
+
+    // While pondering the clock is ignored and think() holds its result until a ponder hit
+    // (the clock limits apply from then on, counted from the search start) or a stop
+    void setPondering(bool value);
+    void ponderHit();
+
+    void setThreads(int count);
+    int getThreads() const;
+    uint64_t getNodes() const;
+    uint64_t getTbHits() const;
+    // Share of the pawn table probes of the last search that hit, over all threads
+    double getPawnHitRate() const;
+    // Share of the beta cutoffs of the last search made by the first move searched, over all threads
+    double getFirstMoveCutoffRate() const;
+
+    void clearHistory();
+    void setInfoCallback(std::function<void(const SearchInfo&)> callback);
+    const SearchInfo& getLastInfo() const;
+};
@@ -0,0 +1,927 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "Attacks.h"
+#include "MoveGen.h"
+#include "Pgn.h"
+#include "Position.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// Engine-vs-engine games for validating changes
+//   selfplay --engine CMD [NAME=VALUE...] --engine CMD [NAME=VALUE...] [options]
+// Each engine is a UCI program started through the shell, the NAME=VALUE pairs after it are
+// sent as setoption, e.g. --engine ./uci Hash=64 "Use NNUE=false". M games run at once, one
+// per thread of the pool, and each thread keeps its own pair of engine processes from game
+// to game. Every opening is played twice with the colors swapped. Games are appended to a
+// PGN file, and after each one the score of the first engine against the second is reported
+// with games/hour, Elo and the log-likelihood ratio of an SPRT, which ends the run once it
+// accepts either hypothesis.
+//   --games N              most games to play (default 100)
+//   --concurrency M        games played at once (default 1)
+//   --tc [MOVES/]SEC[+INC] clock per side, e.g. 10+0.1 or 40/60 (default 10+0.1)
+//   --nodes N, --movetime MS, --depth N
+//                          fixed limit per move instead of a clock
+//   --openings FILE        FEN or EPD start positions, one per line, used in file order
+//   --pgn FILE             where the games are appended
+//   --sprt ELO0,ELO1       stop once the test accepts elo0 (H0) or elo1 (H1)
+//   --alpha A, --beta B    error rates of the test (default 0.05 each)
+//   --max-moves N          adjudicates a draw after N moves per side (default 400)
+//   --margin MS            time a move may overrun its clock or movetime (default 100)
+
+#define SELFPLAY_HANDSHAKE_MS 10000 // For uciok and readyok
+#define SELFPLAY_HANG_MS 300000     // Longest wait for a move without a clock, then the engine is taken for hung
+#define SELFPLAY_QUIT_MS 1000       // Grace time after quit before the process is killed
+
+namespace {
+
+    // ======================
+    // Engine processes
+    // ======================
+
+    // Child process talking UCI over its stdin and stdout. Lines are read with a timeout so a
+    // hung or slow engine cannot block its game thread forever.
+    class EngineProcess {
+#if defined(_WIN32)
+        HANDLE process = nullptr;
+        HANDLE input = nullptr;  // Our end of the child's stdin
+        HANDLE output = nullptr; // Our end of the child's stdout
+#else
+        pid_t pid = -1;
+        int input = -1;
+        int output = -1;
+#endif
+        std::string buffer; // Read but not yet returned
+        bool alive = false;
+
+        // Appends whatever the child writes within the timeout, false on timeout, exit or error
+        bool fill(int timeoutMs);
+    public:
+        EngineProcess() = default;
+        ~EngineProcess() { close(); }
+        EngineProcess(const EngineProcess&) = delete;
+        EngineProcess& operator=(const EngineProcess&) = delete;
+
+        bool start(const std::string& command);
+        // Asks the engine to quit, kills it if it does not
+        void close();
+        bool isAlive() const { return alive; }
+
+        bool send(const std::string& line);
+        // Next line without its line break, false if none comes within the timeout
+        bool readLine(std::string& line, int64_t timeoutMs);
+    };
+
+    // Processes must not inherit the pipes of engines started by other threads, or they keep
+    // them open after that engine exits. Pipes are created and made private under this lock.
+    std::mutex spawnMutex;
+
+#if defined(_WIN32)
+
+    bool EngineProcess::start(const std::string& command) {
+        close();
+        std::lock_guard<std::mutex> lock(spawnMutex);
+        SECURITY_ATTRIBUTES inherit = { sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE };
+        HANDLE childIn, childOut;
+        if (!CreatePipe(&childIn, &input, &inherit, 0)) {
+            return false;
+        }
+        if (!CreatePipe(&output, &childOut, &inherit, 0)) {
+            CloseHandle(childIn);
+            CloseHandle(input);
+            return false;
+        }
+        SetHandleInformation(input, HANDLE_FLAG_INHERIT, 0);
+        SetHandleInformation(output, HANDLE_FLAG_INHERIT, 0);
+
+        STARTUPINFOA startup = {};
+        startup.cb = sizeof(startup);
+        startup.dwFlags = STARTF_USESTDHANDLES;
+        startup.hStdInput = childIn;
+        startup.hStdOutput = childOut;
+        startup.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+        PROCESS_INFORMATION info = {};
+        std::vector<char> commandLine(command.begin(), command.end());
+        commandLine.push_back('\0');
+        bool started = CreateProcessA(nullptr, commandLine.data(), nullptr, nullptr, TRUE, 0, nullptr, nullptr, &startup, &info);
+        CloseHandle(childIn);
+        CloseHandle(childOut);
+        if (!started) {
+            CloseHandle(input);
+            CloseHandle(output);
+            input = output = nullptr;
+            return false;
+        }
+        CloseHandle(info.hThread);
+        process = info.hProcess;
+        alive = true;
+        return true;
+    }
+
+    void EngineProcess::close() {
+        if (process) {
+            if (alive) {
+                send("quit");
+            }
+            if (WaitForSingleObject(process, SELFPLAY_QUIT_MS) != WAIT_OBJECT_0) {
+                TerminateProcess(process, 1);
+                WaitForSingleObject(process, INFINITE);
+            }
+            CloseHandle(process);
+            CloseHandle(input);
+            CloseHandle(output);
+            process = input = output = nullptr;
+        }
+        buffer.clear();
+        alive = false;
+    }
+
+    bool EngineProcess::send(const std::string& line) {
+        std::string text = line + "\n";
+        DWORD written;
+        if (!alive || !WriteFile(input, text.data(), DWORD(text.size()), &written, nullptr) || written != text.size()) {
+            alive = false;
+        }
+        return alive;
+    }
+
+    bool EngineProcess::fill(int timeoutMs) {
+        // Anonymous pipes cannot be waited on, the pipe is polled every millisecond instead
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        while (true) {
+            DWORD available = 0;
+            if (!PeekNamedPipe(output, nullptr, 0, nullptr, &available, nullptr)) {
+                alive = false;
+                return false;
+            }
+            if (available) {
+                char chunk[4096];
+                DWORD got = 0;
+                if (!ReadFile(output, chunk, std::min<DWORD>(available, sizeof(chunk)), &got, nullptr) || !got) {
+                    alive = false;
+                    return false;
+                }
+                buffer.append(chunk, got);
+                return true;
+            }
+            if (std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+            Sleep(1);
+        }
+    }
+
+#else
+
+    bool EngineProcess::start(const std::string& command) {
+        close();
+        // Built before forking, the child may only call async-signal-safe functions
+        std::string script = "exec " + command;
+
+        std::lock_guard<std::mutex> lock(spawnMutex);
+        int toChild[2], fromChild[2];
+        if (pipe(toChild)) {
+            return false;
+        }
+        if (pipe(fromChild)) {
+            ::close(toChild[0]);
+            ::close(toChild[1]);
+            return false;
+        }
+        for (int fd : { toChild[0], toChild[1], fromChild[0], fromChild[1] }) {
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+
+        pid = fork();
+        if (pid == 0) {
+            // dup2 clears close-on-exec on the copies
+            dup2(toChild[0], STDIN_FILENO);
+            dup2(fromChild[1], STDOUT_FILENO);
+            execl("/bin/sh", "sh", "-c", script.c_str(), static_cast<char*>(nullptr));
+            _exit(127);
+        }
+        ::close(toChild[0]);
+        ::close(fromChild[1]);
+        if (pid < 0) {
+            ::close(toChild[1]);
+            ::close(fromChild[0]);
+            return false;
+        }
+        input = toChild[1];
+        output = fromChild[0];
+        alive = true;
+        return true;
+    }
+
+    void EngineProcess::close() {
+        if (pid > 0) {
+            if (alive) {
+                send("quit");
+            }
+            ::close(input);
+            ::close(output);
+            int status;
+            bool exited = false;
+            for (int waited = 0; waited < SELFPLAY_QUIT_MS && !exited; waited += 10) {
+                exited = waitpid(pid, &status, WNOHANG) == pid;
+                if (!exited) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                }
+            }
+            if (!exited) {
+                kill(pid, SIGKILL);
+                waitpid(pid, &status, 0);
+            }
+            pid = -1;
+            input = output = -1;
+        }
+        buffer.clear();
+        alive = false;
+    }
+
+    bool EngineProcess::send(const std::string& line) {
+        std::string text = line + "\n";
+        size_t done = 0;
+        while (alive && done < text.size()) {
+            ssize_t written = write(input, text.data() + done, text.size() - done);
+            if (written <= 0) {
+                alive = false;
+            }
+            else {
+                done += size_t(written);
+            }
+        }
+        return alive;
+    }
+
+    bool EngineProcess::fill(int timeoutMs) {
+        pollfd request = { output, POLLIN, 0 };
+        if (poll(&request, 1, timeoutMs) <= 0) {
+            return false;
+        }
+        char chunk[4096];
+        ssize_t got = read(output, chunk, sizeof(chunk));
+        if (got <= 0) {
+            alive = false;
+            return false;
+        }
+        buffer.append(chunk, size_t(got));
+        return true;
+    }
+
+#endif
+
+    bool EngineProcess::readLine(std::string& line, int64_t timeoutMs) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        while (true) {
+            size_t end = buffer.find('\n');
+            if (end != std::string::npos) {
+                line.assign(buffer, 0, end);
+                buffer.erase(0, end + 1);
+                if (!line.empty() && line.back() == '\r') {
+                    line.pop_back();
+                }
+                return true;
+            }
+            if (!alive) {
+                return false;
+            }
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            if (left <= 0 || (!fill(int(std::min<int64_t>(left, INT32_MAX))) && !alive)) {
+                return false;
+            }
+        }
+    }
+
+    // ======================
+    // Players
+    // ======================
+
+    struct EngineConfig {
+        std::string command;
+        std::vector<std::pair<std::string, std::string>> options;
+        std::string name; // As the engine gives it, made unique by main()
+    };
+
+    // One engine of one game thread. The process is started on first use and again after
+    // it crashed, hung or lost on time, so a bad game never leaks into the next one.
+    class Player {
+        const EngineConfig& config;
+        EngineProcess process;
+
+        // Reads lines until one starts with the token, false if it does not come in time
+        bool waitFor(const std::string& token, int64_t timeoutMs, std::string* line = nullptr) {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+            std::string text;
+            while (true) {
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+                if (!process.readLine(text, std::max<int64_t>(left, 0))) {
+                    return false;
+                }
+                if (text.compare(0, token.size(), token) == 0 && (text.size() == token.size() || text[token.size()] == ' ')) {
+                    if (line) {
+                        *line = text;
+                    }
+                    return true;
+                }
+            }
+        }
+    public:
+        Player(const EngineConfig& config) : config(config) {}
+
+        // Starts the process and goes through the handshake, returns the engine's name
+        bool start(std::string* name = nullptr) {
+            if (!process.start(config.command) || !process.send("uci")) {
+                process.close();
+                return false;
+            }
+            // The id comes before uciok
+            std::string line;
+            while (true) {
+                if (!process.readLine(line, SELFPLAY_HANDSHAKE_MS)) {
+                    process.close();
+                    return false;
+                }
+                if (name && line.compare(0, 8, "id name ") == 0) {
+                    *name = line.substr(8);
+                }
+                if (line == "uciok") {
+                    break;
+                }
+            }
+            for (const auto& option : config.options) {
+                process.send("setoption name " + option.first + " value " + option.second);
+            }
+            return isReady();
+        }
+
+        void stop() {
+            process.close();
+        }
+
+        bool isReady() {
+            if (process.send("isready") && waitFor("readyok", SELFPLAY_HANDSHAKE_MS)) {
+                return true;
+            }
+            process.close();
+            return false;
+        }
+
+        // Clean state for a new game, restarting the process when it is gone
+        bool newGame() {
+            if (process.isAlive() && process.send("ucinewgame") && isReady()) {
+                return true;
+            }
+            return start();
+        }
+
+        // Sends the position and the go command and waits for the move. Empty when the
+        // engine exited or did not answer in time, the caller tells the two apart.
+        std::string play(const std::string& position, const std::string& go, int64_t timeoutMs) {
+            std::string line;
+            if (!process.send(position) || !process.send(go) || !waitFor("bestmove", timeoutMs, &line)) {
+                return "";
+            }
+            std::istringstream ss(line);
+            std::string token, move;
+            ss >> token >> move;
+            return move.empty() ? "(none)" : move;
+        }
+
+        bool isAlive() const { return process.isAlive(); }
+    };
+
+    // ======================
+    // Match setup and statistics
+    // ======================
+
+    // Either a clock, moves/base+increment with moves 0 for sudden death, or a fixed limit per move
+    struct TimeControl {
+        int moves = 0;
+        int64_t baseMs = 10000;
+        int64_t incrementMs = 100;
+        uint64_t nodes = 0;
+        int64_t movetime = 0;
+        int depth = 0;
+
+        bool hasClock() const { return !nodes && !movetime && !depth; }
+
+        bool parse(const std::string& text) {
+            try {
+                size_t slash = text.find('/');
+                size_t plus = text.find('+');
+                moves = slash == std::string::npos ? 0 : std::stoi(text.substr(0, slash));
+                size_t baseStart = slash == std::string::npos ? 0 : slash + 1;
+                baseMs = int64_t(std::stod(text.substr(baseStart, plus - baseStart)) * 1000);
+                incrementMs = plus == std::string::npos ? 0 : int64_t(std::stod(text.substr(plus + 1)) * 1000);
+            }
+            catch (const std::exception&) {
+                return false;
+            }
+            return moves >= 0 && baseMs > 0 && incrementMs >= 0;
+        }
+
+        // PGN TimeControl tag, in seconds
+        std::string toTag() const {
+            if (!hasClock()) {
+                return "-";
+            }
+            auto seconds = [](int64_t ms) {
+                std::ostringstream ss;
+                ss << ms / 1000.0;
+                return ss.str();
+            };
+            std::string tag = (moves ? std::to_string(moves) + "/" : "") + seconds(baseMs);
+            return incrementMs ? tag + "+" + seconds(incrementMs) : tag;
+        }
+    };
+
+    double scoreOf(double elo) {
+        return 1 / (1 + std::pow(10.0, -elo / 400));
+    }
+
+    double eloOf(double score) {
+        score = std::clamp(score, 1e-6, 1 - 1e-6);
+        return -400 * std::log10(1 / score - 1);
+    }
+
+    // Results of the first engine
+    struct Tally {
+        int wins = 0;
+        int draws = 0;
+        int losses = 0;
+
+        int games() const { return wins + draws + losses; }
+        double score() const { return (wins + draws / 2.0) / games(); }
+
+        // Variance of one game's score
+        double variance() const {
+            double s = score();
+            return (wins * (1 - s) * (1 - s) + draws * (0.5 - s) * (0.5 - s) + losses * s * s) / games();
+        }
+
+        // Elo and the half width of its 95% interval
+        void elo(double& value, double& margin) const {
+            double s = score();
+            double deviation = std::sqrt(variance() / games());
+            value = eloOf(s);
+            margin = (eloOf(s + 1.96 * deviation) - eloOf(s - 1.96 * deviation)) / 2;
+        }
+
+        // Log-likelihood ratio of elo1 against elo0, with the generalized SPRT approximation
+        // that treats the game scores as normal with the observed mean and variance
+        double llr(double elo0, double elo1) const {
+            if (!games() || variance() <= 0) {
+                return 0;
+            }
+            double s0 = scoreOf(elo0);
+            double s1 = scoreOf(elo1);
+            return games() * (s1 - s0) * (2 * score() - s0 - s1) / (2 * variance());
+        }
+    };
+
+    struct GameRecord {
+        int index;
+        int white; // Engine playing white, 0 or 1
+        std::string startFen;
+        std::vector<Move> moves;
+        std::string result;
+        std::string termination;
+    };
+
+    // Everything the game threads share. Results are recorded under the mutex, which also
+    // serializes the PGN file and the console.
+    struct Match {
+        EngineConfig engines[2];
+        TimeControl tc;
+        std::vector<std::string> openings;
+        int games = 100;
+        int maxMoves = 400;
+        int64_t marginMs = 100;
+        std::string date;
+
+        bool sprt = false;
+        double elo0 = 0;
+        double elo1 = 5;
+        double alpha = 0.05;
+        double beta = 0.05;
+
+        std::atomic<int> nextGame{ 0 };
+        std::atomic<bool> stopping{ false };
+        std::chrono::steady_clock::time_point startTime;
+
+        std::mutex mutex;
+        std::ofstream pgnFile;
+        Tally tally;
+        std::string verdict;
+
+        double lowerBound() const { return std::log(beta / (1 - alpha)); }
+        double upperBound() const { return std::log((1 - beta) / alpha); }
+
+        void printStatus() {
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            double elo, margin;
+            tally.elo(elo, margin);
+            std::cout << "Score of " << engines[0].name << " vs " << engines[1].name << ": "
+                << tally.wins << " - " << tally.losses << " - " << tally.draws
+                << "  [" << std::fixed << std::setprecision(3) << tally.score() << "] " << tally.games()
+                << "  Elo " << std::setprecision(1) << elo << " +/- " << margin;
+            if (sprt) {
+                std::cout << "  LLR " << std::setprecision(2) << tally.llr(elo0, elo1)
+                    << " (" << lowerBound() << ", " << upperBound() << ")";
+            }
+            std::cout << "  games/hour " << std::setprecision(0) << tally.games() * 3600 / std::max(elapsed, 1e-3) << std::endl;
+        }
+
+        void record(const GameRecord& game) {
+            std::lock_guard<std::mutex> lock(mutex);
+            const std::string& white = engines[game.white].name;
+            const std::string& black = engines[1 - game.white].name;
+            if (game.result == "1/2-1/2") {
+                tally.draws++;
+            }
+            else if ((game.result == "1-0") == (game.white == 0)) {
+                tally.wins++;
+            }
+            else {
+                tally.losses++;
+            }
+
+            if (pgnFile.is_open()) {
+                std::vector<std::pair<std::string, std::string>> tags = {
+                    { "Event", "Self-play" },
+                    { "Site", "?" },
+                    { "Date", date },
+                    { "Round", std::to_string(game.index + 1) },
+                    { "White", white },
+                    { "Black", black },
+                    { "Result", game.result },
+                    { "TimeControl", tc.toTag() },
+                    { "Termination", game.termination },
+                };
+                pgnFile << pgn::write(tags, game.startFen, game.moves, game.result) << std::flush;
+            }
+
+            std::cout << "Finished game " << game.index + 1 << " (" << white << " vs " << black << "): "
+                << game.result << " {" << game.termination << "}" << std::endl;
+            printStatus();
+
+            if (sprt && verdict.empty()) {
+                double llr = tally.llr(elo0, elo1);
+                if (llr >= upperBound()) {
+                    verdict = "H1 accepted";
+                }
+                else if (llr <= lowerBound()) {
+                    verdict = "H0 accepted";
+                }
+                if (!verdict.empty()) {
+                    std::cout << "SPRT: " << verdict << ", finishing the games in progress" << std::endl;
+                    stopping = true;
+                }
+            }
+        }
+    };
+
+    // ======================
+    // Games
+    // ======================
+
+    std::string goCommand(const Match& match, const int64_t clock[COLOR_NB], int movesToGo) {
+        const TimeControl& tc = match.tc;
+        if (tc.nodes) {
+            return "go nodes " + std::to_string(tc.nodes);
+        }
+        if (tc.movetime) {
+            return "go movetime " + std::to_string(tc.movetime);
+        }
+        if (tc.depth) {
+            return "go depth " + std::to_string(tc.depth);
+        }
+        std::string go = "go wtime " + std::to_string(std::max<int64_t>(clock[WHITE], 1))
+            + " btime " + std::to_string(std::max<int64_t>(clock[BLACK], 1))
+            + " winc " + std::to_string(tc.incrementMs) + " binc " + std::to_string(tc.incrementMs);
+        return movesToGo ? go + " movestogo " + std::to_string(movesToGo) : go;
+    }
+
+    // Plays one game, both players ready for it. A player that crashes, hangs, loses on
+    // time or sends an illegal move loses the game and is stopped.
+    GameRecord playGame(Match& match, Player* players, int index) {
+        const TimeControl& tc = match.tc;
+        GameRecord game;
+        game.index = index;
+        game.white = index % 2;
+        game.startFen = match.openings[size_t(index / 2) % match.openings.size()];
+
+        Position position;
+        position.setFen(game.startFen);
+        std::string positionCommand = game.startFen == START_FEN ? "position startpos moves" : "position fen " + game.startFen + " moves";
+        int64_t clock[COLOR_NB] = { tc.baseMs, tc.baseMs };
+        int movesMade[COLOR_NB] = { 0, 0 };
+
+        auto lose = [&game](Color loser, const char* termination) {
+            game.result = loser == WHITE ? "0-1" : "1-0";
+            game.termination = termination;
+        };
+
+        while (true) {
+            MoveList legal;
+            generateMoves(position, legal);
+            if (legal.empty()) {
+                if (position.isInCheck()) {
+                    lose(position.getSideToMove(), "normal");
+                }
+                else {
+                    game.result = "1/2-1/2";
+                    game.termination = "normal";
+                }
+                return game;
+            }
+            // The game rules rather than the search's single repetition: three-fold, fifty moves, bare minors
+            if (position.getHalfmoveClock() >= 100 || position.getRepetitionCount() >= 2 || position.isMaterialDraw()) {
+                game.result = "1/2-1/2";
+                game.termination = "normal";
+                return game;
+            }
+            if (int(game.moves.size()) >= 2 * match.maxMoves) {
+                game.result = "1/2-1/2";
+                game.termination = "adjudication";
+                return game;
+            }
+
+            Color us = position.getSideToMove();
+            Player& player = players[us == WHITE ? game.white : 1 - game.white];
+            int movesToGo = tc.moves ? tc.moves - movesMade[us] % tc.moves : 0;
+            int64_t timeout = tc.movetime ? tc.movetime + match.marginMs
+                : tc.hasClock() ? clock[us] + match.marginMs : SELFPLAY_HANG_MS;
+
+            auto start = std::chrono::steady_clock::now();
+            std::string reply = player.play(positionCommand, goCommand(match, clock, movesToGo), timeout);
+            int64_t elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+            if (reply.empty()) {
+                bool crashed = !player.isAlive();
+                player.stop();
+                lose(us, crashed ? "abandoned" : "time forfeit");
+                return game;
+            }
+            if (tc.hasClock()) {
+                clock[us] -= elapsed;
+                if (clock[us] + match.marginMs < 0) {
+                    player.stop();
+                    lose(us, "time forfeit");
+                    return game;
+                }
+                clock[us] = std::max<int64_t>(clock[us], 0) + tc.incrementMs;
+                if (tc.moves && ++movesMade[us] % tc.moves == 0) {
+                    clock[us] += tc.baseMs;
+                }
+            }
+
+            Move move = parseUciMove(position, reply);
+            if (move.isNull()) {
+                std::lock_guard<std::mutex> lock(match.mutex);
+                std::cout << "Illegal move " << reply << " in " << position.getFen() << std::endl;
+                player.stop();
+                lose(us, "rules infraction");
+                return game;
+            }
+            position.makeMove(move);
+            game.moves.push_back(move);
+            positionCommand += " " + move.toString();
+        }
+    }
+
+    // Body of each pool thread: takes the next game until the match is over
+    void runGames(Match& match) {
+        Player players[2] = { Player(match.engines[0]), Player(match.engines[1]) };
+        while (!match.stopping) {
+            int index = match.nextGame++;
+            if (index >= match.games) {
+                break;
+            }
+            if (!players[0].newGame() || !players[1].newGame()) {
+                std::lock_guard<std::mutex> lock(match.mutex);
+                std::cout << "Unable to start the engines, stopping" << std::endl;
+                match.stopping = true;
+                break;
+            }
+            GameRecord game = playGame(match, players, index);
+            match.record(game);
+        }
+        players[0].stop();
+        players[1].stop();
+    }
+
+    // Start positions from a file of FENs or EPDs. EPD lines only have the first four FEN
+    // fields followed by operations, their move counters start from zero.
+    bool loadOpenings(const std::string& path, std::vector<std::string>& openings) {
+        std::ifstream in(path);
+        if (!in) {
+            return false;
+        }
+        std::string line;
+        Position position;
+        while (std::getline(in, line)) {
+            std::istringstream ss(line);
+            std::string fields[6];
+            int count = 0;
+            while (count < 6 && ss >> fields[count]) {
+                count++;
+            }
+            if (count < 4 || fields[0][0] == '#') {
+                continue;
+            }
+            std::string fen = fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3];
+            bool counters = count == 6 && std::all_of(fields[4].begin(), fields[4].end(), ::isdigit)
+                && std::all_of(fields[5].begin(), fields[5].end(), ::isdigit);
+            fen += counters ? " " + fields[4] + " " + fields[5] : " 0 1";
+            if (!position.setFen(fen)) {
+                std::cout << "Skipping invalid position " << line << std::endl;
+                continue;
+            }
+            openings.push_back(position.getFen());
+        }
+        return true;
+    }
+
+    void printUsage() {
+        std::cout << "Usage: selfplay --engine CMD [NAME=VALUE...] --engine CMD [NAME=VALUE...]" << std::endl;
+        std::cout << "                [--games N] [--concurrency M] [--tc [MOVES/]SEC[+INC] | --nodes N | --movetime MS | --depth N]" << std::endl;
+        std::cout << "                [--openings FILE] [--pgn FILE] [--sprt ELO0,ELO1] [--alpha A] [--beta B]" << std::endl;
+        std::cout << "                [--max-moves N] [--margin MS]" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+#if !defined(_WIN32)
+    // A dead engine shows up as a failed write instead of killing the runner
+    signal(SIGPIPE, SIG_IGN);
+#endif
+    attacks::init();
+
+    Match match;
+    int engineCount = 0;
+    int concurrency = 1;
+    std::string openingsPath, pgnPath;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        try {
+            if (arg == "--engine" && hasValue && engineCount < 2) {
+                EngineConfig& engine = match.engines[engineCount++];
+                engine.command = argv[++i];
+                while (i + 1 < argc && strncmp(argv[i + 1], "--", 2) && strchr(argv[i + 1], '=')) {
+                    std::string option = argv[++i];
+                    size_t equals = option.find('=');
+                    engine.options.emplace_back(option.substr(0, equals), option.substr(equals + 1));
+                }
+            }
+            else if (arg == "--games" && hasValue) {
+                match.games = std::stoi(argv[++i]);
+            }
+            else if (arg == "--concurrency" && hasValue) {
+                concurrency = std::max(std::stoi(argv[++i]), 1);
+            }
+            else if (arg == "--tc" && hasValue) {
+                if (!match.tc.parse(argv[++i])) {
+                    std::cerr << "Invalid time control " << argv[i] << std::endl;
+                    return 1;
+                }
+            }
+            else if (arg == "--nodes" && hasValue) {
+                match.tc.nodes = std::stoull(argv[++i]);
+            }
+            else if (arg == "--movetime" && hasValue) {
+                match.tc.movetime = std::stoll(argv[++i]);
+            }
+            else if (arg == "--depth" && hasValue) {
+                match.tc.depth = std::stoi(argv[++i]);
+            }
+            else if (arg == "--openings" && hasValue) {
+                openingsPath = argv[++i];
+            }
+            else if (arg == "--pgn" && hasValue) {
+                pgnPath = argv[++i];
+            }
+            else if (arg == "--sprt" && hasValue) {
+                std::string bounds = argv[++i];
+                size_t comma = bounds.find(',');
+                match.elo0 = std::stod(bounds.substr(0, comma));
+                match.elo1 = std::stod(bounds.substr(comma + 1));
+                match.sprt = comma != std::string::npos && match.elo1 != match.elo0;
+            }
+            else if (arg == "--alpha" && hasValue) {
+                match.alpha = std::stod(argv[++i]);
+            }
+            else if (arg == "--beta" && hasValue) {
+                match.beta = std::stod(argv[++i]);
+            }
+            else if (arg == "--max-moves" && hasValue) {
+                match.maxMoves = std::stoi(argv[++i]);
+            }
+            else if (arg == "--margin" && hasValue) {
+                match.marginMs = std::stoll(argv[++i]);
+            }
+            else {
+                printUsage();
+                return 1;
+            }
+        }
+        catch (const std::exception&) {
+            std::cerr << "Invalid value for " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (engineCount != 2 || match.games < 1) {
+        printUsage();
+        return 1;
+    }
+    match.maxMoves = std::max(match.maxMoves, 1);
+
+    if (!openingsPath.empty()) {
+        if (!loadOpenings(openingsPath, match.openings)) {
+            std::cerr << "Unable to open " << openingsPath << std::endl;
+            return 1;
+        }
+        if (match.openings.empty()) {
+            std::cerr << "No positions in " << openingsPath << std::endl;
+            return 1;
+        }
+    }
+    else {
+        match.openings.push_back(START_FEN);
+    }
+    if (!pgnPath.empty()) {
+        match.pgnFile.open(pgnPath, std::ios::app);
+        if (!match.pgnFile) {
+            std::cerr << "Unable to open " << pgnPath << std::endl;
+            return 1;
+        }
+    }
+
+    // Each engine is started once up front, so a wrong command fails here and not in every thread
+    for (int i = 0; i < 2; i++) {
+        Player player(match.engines[i]);
+        std::string name = "Engine " + std::to_string(i + 1);
+        if (!player.start(&name)) {
+            std::cerr << "Unable to start " << match.engines[i].command << std::endl;
+            return 1;
+        }
+        player.stop();
+        match.engines[i].name = name;
+    }
+    if (match.engines[0].name == match.engines[1].name) {
+        match.engines[0].name += " (1)";
+        match.engines[1].name += " (2)";
+    }
+
+    std::time_t now = std::time(nullptr);
+    char date[16];
+    std::strftime(date, sizeof(date), "%Y.%m.%d", std::localtime(&now));
+    match.date = date;
+
+    std::cout << match.engines[0].name << " vs " << match.engines[1].name << ", " << match.games << " games, "
+        << concurrency << " at once, " << match.openings.size() << " openings";
+    if (match.tc.hasClock()) {
+        std::cout << ", tc " << match.tc.toTag();
+    }
+    std::cout << std::endl;
+
+    match.startTime = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (int i = 0; i < std::min(concurrency, match.games); i++) {
+        pool.emplace_back(runGames, std::ref(match));
+    }
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+
+    if (match.sprt) {
+        std::cout << std::defaultfloat << std::setprecision(6) << "SPRT (" << match.elo0 << ", " << match.elo1 << "): "
+            << (match.verdict.empty() ? "inconclusive" : match.verdict) << std::endl;
+    }
+    return 0;
+}
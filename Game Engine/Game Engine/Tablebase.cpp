@@ -0,0 +1,1036 @@
+#include "Tablebase.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "MappedFile.h"
+#include "TablebaseFormat.h"
+
+// ======================
+// Index encoding
+// ======================
+
+namespace tablebase {
+
+    namespace {
+        int mapPawns[64];        // Pawn squares a2..h7 ranked from the edge and rank 2 down to 0
+        int mapB1H1H7[64];       // Squares below the a1-h8 diagonal to 0..27
+        int mapA1D1D4[64];       // Squares of the a1-d1-d4 triangle to 0..9, diagonal last
+        int mapKK[10][64];       // The 462 placements of two kings, the first in the triangle
+        uint64_t binomial[6][64]; // Ways to choose k of n squares
+        uint64_t leadPawnIdx[6][64];
+        uint64_t leadPawnsSize[6][4];
+        bool encodingReady = false;
+
+        int offA1H8(int sq) {
+            return rankOf(sq) - fileOf(sq);
+        }
+
+        bool pawnBefore(int a, int b) {
+            return mapPawns[a] < mapPawns[b];
+        }
+    }
+
+    uint64_t TableLayout::size() const {
+        int n = 0;
+        while (groupLen[n]) {
+            n++;
+        }
+        return groupIdx[n];
+    }
+
+    void initEncoding() {
+        if (encodingReady) {
+            return;
+        }
+
+        int code = 0;
+        for (int sq = 0; sq < 64; sq++) {
+            if (offA1H8(sq) < 0) {
+                mapB1H1H7[sq] = code++;
+            }
+        }
+
+        code = 0;
+        std::vector<int> diagonal;
+        for (int sq = A1; sq <= D4; sq++) {
+            if (offA1H8(sq) < 0 && fileOf(sq) <= 3) {
+                mapA1D1D4[sq] = code++;
+            }
+            else if (!offA1H8(sq) && fileOf(sq) <= 3) {
+                diagonal.push_back(sq);
+            }
+        }
+        for (int sq : diagonal) {
+            mapA1D1D4[sq] = code++;
+        }
+
+        // With the first king on the diagonal the second one stays on or below it, and
+        // placements with both kings on the diagonal come last
+        code = 0;
+        std::vector<std::pair<int, int>> bothOnDiagonal;
+        for (int idx = 0; idx < 10; idx++) {
+            for (int s1 = A1; s1 <= D4; s1++) {
+                if (mapA1D1D4[s1] != idx || (!idx && s1 != B1)) {
+                    continue;
+                }
+                for (int s2 = 0; s2 < 64; s2++) {
+                    if ((attacks::kingAttacks(s1) | squareBB(s1)) & squareBB(s2)) {
+                        continue;
+                    }
+                    if (!offA1H8(s1) && offA1H8(s2) > 0) {
+                        continue;
+                    }
+                    if (!offA1H8(s1) && !offA1H8(s2)) {
+                        bothOnDiagonal.emplace_back(idx, s2);
+                    }
+                    else {
+                        mapKK[idx][s2] = code++;
+                    }
+                }
+            }
+        }
+        for (const auto& placement : bothOnDiagonal) {
+            mapKK[placement.first][placement.second] = code++;
+        }
+
+        binomial[0][0] = 1;
+        for (int n = 1; n < 64; n++) {
+            for (int k = 0; k < 6 && k <= n; k++) {
+                binomial[k][n] = (k > 0 ? binomial[k - 1][n - 1] : 0) + (k < n ? binomial[k][n - 1] : 0);
+            }
+        }
+
+        // The leading pawn is the one with the highest mapPawns, the others can only be on
+        // squares ranked below it. Indices restart for every file, tables are split by file.
+        int available = 47;
+        for (int leadPawns = 1; leadPawns <= 5; leadPawns++) {
+            for (int file = 0; file < 4; file++) {
+                uint64_t idx = 0;
+                for (int rank = 1; rank <= 6; rank++) {
+                    int sq = makeSquare(file, rank);
+                    if (leadPawns == 1) {
+                        mapPawns[sq] = available--;
+                        mapPawns[sq ^ 7] = available--;
+                    }
+                    leadPawnIdx[leadPawns][sq] = idx;
+                    idx += binomial[leadPawns - 1][mapPawns[sq]];
+                }
+                leadPawnsSize[leadPawns][file] = idx;
+            }
+        }
+        encodingReady = true;
+    }
+
+    void setGroups(const TableMaterial& material, TableLayout& layout, const int order[2], int file) {
+        int n = 0;
+        int firstLen = material.hasPawns ? 0 : material.hasUniquePieces ? 3 : 2;
+        layout.groupLen[n] = 1;
+        for (int i = 1; i < material.pieceCount; i++) {
+            if (--firstLen > 0 || layout.pieces[i] == layout.pieces[i - 1]) {
+                layout.groupLen[n]++;
+            }
+            else {
+                layout.groupLen[++n] = 1;
+            }
+        }
+        layout.groupLen[++n] = 0;
+
+        // The index is g1 * N(g2) * N(g3) + g2 * N(g3) + g3 for groups taken in the table's
+        // order, the leading group at order[0] and the other pawns at order[1]
+        bool bothPawns = material.hasPawns && material.pawnCount[1];
+        int next = bothPawns ? 2 : 1;
+        int freeSquares = 64 - layout.groupLen[0] - (bothPawns ? layout.groupLen[1] : 0);
+        uint64_t idx = 1;
+        for (int k = 0; next < n || k == order[0] || k == order[1]; k++) {
+            if (k == order[0]) {
+                layout.groupIdx[0] = idx;
+                idx *= material.hasPawns ? leadPawnsSize[layout.groupLen[0]][file] : material.hasUniquePieces ? 31332 : 462;
+            }
+            else if (k == order[1]) {
+                layout.groupIdx[1] = idx;
+                idx *= binomial[layout.groupLen[1]][48 - layout.groupLen[0]];
+            }
+            else {
+                layout.groupIdx[next] = idx;
+                idx *= binomial[layout.groupLen[next]][freeSquares];
+                freeSquares -= layout.groupLen[next++];
+            }
+        }
+        layout.groupIdx[n] = idx;
+    }
+
+    int leadPawnFile(int* squares, int count) {
+        std::swap(squares[0], *std::max_element(squares, squares + count, pawnBefore));
+        return std::min(fileOf(squares[0]), 7 - fileOf(squares[0]));
+    }
+
+    uint64_t encode(const TableMaterial& material, const TableLayout& layout, int* squares, uint8_t* pieces, int count, int leadPawns) {
+        // Same piece sequence as the table
+        for (int i = leadPawns; i < count - 1; i++) {
+            for (int j = i + 1; j < count; j++) {
+                if (layout.pieces[i] == pieces[j]) {
+                    std::swap(pieces[i], pieces[j]);
+                    std::swap(squares[i], squares[j]);
+                    break;
+                }
+            }
+        }
+
+        // Leading piece or pawn on files a..d
+        if (fileOf(squares[0]) > 3) {
+            for (int i = 0; i < count; i++) {
+                squares[i] ^= 7;
+            }
+        }
+
+        uint64_t idx;
+        if (material.hasPawns) {
+            idx = leadPawnIdx[leadPawns][squares[0]];
+            std::stable_sort(squares + 1, squares + leadPawns, pawnBefore);
+            for (int i = 1; i < leadPawns; i++) {
+                idx += binomial[i][mapPawns[squares[i]]];
+            }
+        }
+        else {
+            // Without pawns the leading piece also goes below rank 5, and the first piece of
+            // the leading group off the a1-h8 diagonal below it
+            if (rankOf(squares[0]) > 3) {
+                for (int i = 0; i < count; i++) {
+                    squares[i] ^= 56;
+                }
+            }
+            for (int i = 0; i < layout.groupLen[0]; i++) {
+                if (!offA1H8(squares[i])) {
+                    continue;
+                }
+                if (offA1H8(squares[i]) > 0) {
+                    for (int j = i; j < count; j++) {
+                        squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+                    }
+                }
+                break;
+            }
+
+            if (material.hasUniquePieces) {
+                // Three unique pieces together: 6 x 63 x 62 placements with the first one
+                // below the diagonal, then the ones with one, two or three on the diagonal
+                int adjust1 = squares[1] > squares[0];
+                int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+                if (offA1H8(squares[0])) {
+                    idx = (uint64_t(mapA1D1D4[squares[0]]) * 63 + (squares[1] - adjust1)) * 62 + squares[2] - adjust2;
+                }
+                else if (offA1H8(squares[1])) {
+                    idx = (6 * 63 + uint64_t(rankOf(squares[0])) * 28 + mapB1H1H7[squares[1]]) * 62 + squares[2] - adjust2;
+                }
+                else if (offA1H8(squares[2])) {
+                    idx = 6 * 63 * 62 + 4 * 28 * 62 + uint64_t(rankOf(squares[0])) * 7 * 28
+                        + (rankOf(squares[1]) - adjust1) * 28 + mapB1H1H7[squares[2]];
+                }
+                else {
+                    idx = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + uint64_t(rankOf(squares[0])) * 7 * 6
+                        + (rankOf(squares[1]) - adjust1) * 6 + (rankOf(squares[2]) - adjust2);
+                }
+            }
+            else {
+                idx = mapKK[mapA1D1D4[squares[0]]][squares[1]];
+            }
+        }
+        idx *= layout.groupIdx[0];
+
+        // Every other group is a combination of the squares the earlier groups left free
+        int* groupSq = squares + layout.groupLen[0];
+        bool remainingPawns = material.hasPawns && material.pawnCount[1];
+        for (int next = 1; layout.groupLen[next]; next++) {
+            std::stable_sort(groupSq, groupSq + layout.groupLen[next]);
+            uint64_t n = 0;
+            for (int i = 0; i < layout.groupLen[next]; i++) {
+                int adjust = int(std::count_if(squares, groupSq, [&](int sq) { return groupSq[i] > sq; }));
+                n += binomial[i + 1][groupSq[i] - adjust - 8 * remainingPawns];
+            }
+            remainingPawns = false;
+            idx += n * layout.groupIdx[next];
+            groupSq += layout.groupLen[next];
+        }
+        return idx;
+    }
+}
+
+// ======================
+// Table files
+// ======================
+
+namespace tablebase {
+
+    namespace {
+        enum TableType { WDL, DTZ };
+
+        // Everything is little endian but the compressed stream
+        uint16_t readLE16(const uint8_t* p) {
+            return uint16_t(p[0] | p[1] << 8);
+        }
+
+        uint32_t readLE32(const uint8_t* p) {
+            return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+        }
+
+        uint32_t readBE32(const uint8_t* p) {
+            return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | uint32_t(p[3]);
+        }
+
+        // Values of one side and leading pawn file of a table. The values are cut into blocks
+        // of canonical Huffman codes, each code standing for a symbol that a binary tree of
+        // pairs expands into one or more consecutive values.
+        struct PairsData {
+            TableLayout layout;
+            uint8_t flags = 0;
+            int minSymLen = 0; // Also the value itself in a single value table
+            int maxSymLen = 0;
+            uint32_t numBlocks = 0;
+            uint64_t blockSize = 0;
+            uint64_t span = 0; // Values between two sparse index entries
+            const uint8_t* lowestSym = nullptr; // Lowest symbol of each code length
+            const uint8_t* btree = nullptr;     // Two 12 bit children per symbol
+            const uint8_t* blockLength = nullptr; // Values in each block, minus one
+            uint32_t blockLengthSize = 0;
+            const uint8_t* sparseIndex = nullptr; // Block and offset of every span-th value
+            uint64_t sparseIndexSize = 0;
+            const uint8_t* data = nullptr;
+            std::vector<uint64_t> base64; // Lowest code of each length, left aligned
+            std::vector<uint8_t> symLen;  // Values a symbol expands to, minus one
+            uint16_t mapIdx[4] = {};      // DTZ: start of the map of each result
+        };
+
+        struct TableFile {
+            std::atomic<bool> ready{ false };
+            bool loaded = false; // Found and valid, only meaningful once ready
+            MappedFile file;
+            const uint8_t* map = nullptr;
+            PairsData sides[2][4]; // [side to move][leading pawn file]
+        };
+
+        // One material signature such as KRPvKR with both its tables
+        struct TableEntry {
+            std::string name;
+            uint64_t key = 0;  // Material with the first side of the name as white
+            uint64_t key2 = 0; // The same with the colors swapped
+            TableMaterial material;
+            TableFile files[2];
+        };
+
+        std::deque<TableEntry> entries;
+        std::unordered_map<uint64_t, TableEntry*> entryByKey;
+        std::vector<std::string> directories;
+        std::string tablePaths;
+        int maxPieces = 0;
+        std::mutex loadMutex;
+
+        const char PIECE_CHARS[] = "PNBRQK";
+
+        // Four bits per piece count, enough for any legal material
+        uint64_t materialKey(const int counts[COLOR_NB][PIECE_TYPE_NB], bool swapColors) {
+            uint64_t key = 0;
+            for (int c = 0; c < COLOR_NB; c++) {
+                for (int pt = 0; pt < PIECE_TYPE_NB; pt++) {
+                    key |= uint64_t(counts[c ^ swapColors][pt]) << (4 * (c * PIECE_TYPE_NB + pt));
+                }
+            }
+            return key;
+        }
+
+        uint64_t materialKey(const Position& position) {
+            int counts[COLOR_NB][PIECE_TYPE_NB];
+            for (int c = 0; c < COLOR_NB; c++) {
+                for (int pt = 0; pt < PIECE_TYPE_NB; pt++) {
+                    counts[c][pt] = popcount(position.getPieces(Color(c), PieceType(pt)));
+                }
+            }
+            return materialKey(counts, false);
+        }
+
+        // Symbol tree helpers
+        int leftSymbol(const PairsData& d, int sym) {
+            const uint8_t* lr = d.btree + 3 * sym;
+            return ((lr[1] & 0xF) << 8) | lr[0];
+        }
+
+        int rightSymbol(const PairsData& d, int sym) {
+            const uint8_t* lr = d.btree + 3 * sym;
+            return (lr[2] << 4) | (lr[1] >> 4);
+        }
+
+        uint8_t setSymLen(PairsData& d, int sym, std::vector<bool>& visited) {
+            visited[sym] = true;
+            int right = rightSymbol(d, sym);
+            if (right == 0xFFF) {
+                return 0;
+            }
+            int left = leftSymbol(d, sym);
+            if (left >= int(d.symLen.size()) || right >= int(d.symLen.size())) {
+                return 0;
+            }
+            if (!visited[left]) {
+                d.symLen[left] = setSymLen(d, left, visited);
+            }
+            if (!visited[right]) {
+                d.symLen[right] = setSymLen(d, right, visited);
+            }
+            return uint8_t(d.symLen[left] + d.symLen[right] + 1);
+        }
+
+        // Reads the block and code parameters of a side, null if they run past the file
+        const uint8_t* setSizes(PairsData& d, const uint8_t* data, const uint8_t* end) {
+            if (end - data < 2) {
+                return nullptr;
+            }
+            d.flags = *data++;
+            if (d.flags & TB_SINGLE_VALUE) {
+                d.minSymLen = *data++;
+                return data;
+            }
+
+            if (end - data < 10) {
+                return nullptr;
+            }
+            uint64_t tableSize = d.layout.size();
+            d.blockSize = 1ULL << *data++;
+            d.span = 1ULL << *data++;
+            d.sparseIndexSize = (tableSize + d.span - 1) / d.span;
+            int padding = *data++;
+            d.numBlocks = readLE32(data);
+            data += 4;
+            d.blockLengthSize = d.numBlocks + padding;
+            d.maxSymLen = *data++;
+            d.minSymLen = *data++;
+            if (d.minSymLen < 1 || d.maxSymLen < d.minSymLen || d.maxSymLen > 32) {
+                return nullptr;
+            }
+
+            // Canonical code: longer codes have lower values, and within a length the codes
+            // count up with the symbols. base64 holds the lowest code of each length
+            // left aligned on 64 bits, so the length of the code in front of a buffer is
+            // found by comparing the buffer with them.
+            d.lowestSym = data;
+            d.base64.assign(d.maxSymLen - d.minSymLen + 1, 0);
+            if (end - data < ptrdiff_t(2 * d.base64.size() + 2)) {
+                return nullptr;
+            }
+            for (int i = int(d.base64.size()) - 2; i >= 0; i--) {
+                d.base64[i] = (d.base64[i + 1] + readLE16(d.lowestSym + 2 * i) - readLE16(d.lowestSym + 2 * (i + 1))) / 2;
+            }
+            for (size_t i = 0; i < d.base64.size(); i++) {
+                d.base64[i] <<= 64 - i - d.minSymLen;
+            }
+            data += 2 * d.base64.size();
+
+            d.symLen.assign(readLE16(data), 0);
+            data += 2;
+            d.btree = data;
+            if (end - data < ptrdiff_t(3 * d.symLen.size())) {
+                return nullptr;
+            }
+            std::vector<bool> visited(d.symLen.size());
+            for (size_t sym = 0; sym < d.symLen.size(); sym++) {
+                if (!visited[sym]) {
+                    d.symLen[sym] = setSymLen(d, int(sym), visited);
+                }
+            }
+            return data + 3 * d.symLen.size() + (d.symLen.size() & 1);
+        }
+
+        // DTZ tables may store an index per result into a table of actual distances
+        const uint8_t* setDtzMap(TableFile& f, const uint8_t* base, const uint8_t* data, int maxFile) {
+            f.map = data;
+            for (int file = 0; file <= maxFile; file++) {
+                PairsData& d = f.sides[0][file];
+                if (!(d.flags & TB_MAPPED)) {
+                    continue;
+                }
+                if (d.flags & TB_WIDE) {
+                    data += (data - base) & 1;
+                    for (int i = 0; i < 4; i++) {
+                        d.mapIdx[i] = uint16_t((data - f.map) / 2 + 1);
+                        data += 2 * readLE16(data) + 2;
+                    }
+                }
+                else {
+                    for (int i = 0; i < 4; i++) {
+                        d.mapIdx[i] = uint16_t(data - f.map + 1);
+                        data += *data + 1;
+                    }
+                }
+            }
+            return data + ((data - base) & 1);
+        }
+
+        // Header layout: flags, then per leading pawn file the group order and the piece
+        // sequence of each side, the code parameters of every side, the DTZ maps, and the
+        // sparse indices, block lengths and 64 byte aligned compressed blocks of every side
+        bool parseTable(TableEntry& e, TableFile& f, TableType type) {
+            const uint8_t* base = f.file.data();
+            const uint8_t* end = base + f.file.size();
+            const uint8_t* data = base + 4;
+
+            bool split = e.key != e.key2;
+            int sides = type == WDL && split ? 2 : 1;
+            int maxFile = e.material.hasPawns ? 3 : 0;
+            bool bothPawns = e.material.hasPawns && e.material.pawnCount[1];
+            if (bool(*data & TB_HAS_PAWNS) != e.material.hasPawns || bool(*data & TB_SPLIT) != split) {
+                return false;
+            }
+            data++;
+
+            for (int file = 0; file <= maxFile; file++) {
+                if (end - data < 2 + e.material.pieceCount) {
+                    return false;
+                }
+                int order[2][2] = {
+                    { *data & 0xF, bothPawns ? data[1] & 0xF : 0xF },
+                    { *data >> 4, bothPawns ? data[1] >> 4 : 0xF }
+                };
+                data += 1 + bothPawns;
+                for (int k = 0; k < e.material.pieceCount; k++, data++) {
+                    for (int i = 0; i < sides; i++) {
+                        f.sides[i][file].layout.pieces[k] = uint8_t(i ? *data >> 4 : *data & 0xF);
+                    }
+                }
+                for (int i = 0; i < sides; i++) {
+                    // The piece sequence has to be the table's material, the encoding trusts it
+                    int counts[COLOR_NB][PIECE_TYPE_NB] = {};
+                    for (int k = 0; k < e.material.pieceCount; k++) {
+                        uint8_t piece = f.sides[i][file].layout.pieces[k];
+                        if ((piece & 7) < 1 || (piece & 7) > 6) {
+                            return false;
+                        }
+                        counts[filePieceColor(piece)][filePieceType(piece)]++;
+                    }
+                    if (materialKey(counts, false) != e.key) {
+                        return false;
+                    }
+                    setGroups(e.material, f.sides[i][file].layout, order[i], file);
+                }
+            }
+            data += (data - base) & 1;
+
+            for (int file = 0; file <= maxFile; file++) {
+                for (int i = 0; i < sides; i++) {
+                    data = setSizes(f.sides[i][file], data, end);
+                    if (!data) {
+                        return false;
+                    }
+                }
+            }
+            if (type == DTZ) {
+                data = setDtzMap(f, base, data, maxFile);
+            }
+            for (int file = 0; file <= maxFile; file++) {
+                for (int i = 0; i < sides; i++) {
+                    PairsData& d = f.sides[i][file];
+                    d.sparseIndex = data;
+                    data += 6 * d.sparseIndexSize;
+                }
+            }
+            for (int file = 0; file <= maxFile; file++) {
+                for (int i = 0; i < sides; i++) {
+                    PairsData& d = f.sides[i][file];
+                    d.blockLength = data;
+                    data += 2 * uint64_t(d.blockLengthSize);
+                }
+            }
+            for (int file = 0; file <= maxFile; file++) {
+                for (int i = 0; i < sides; i++) {
+                    PairsData& d = f.sides[i][file];
+                    data = base + ((data - base + 0x3F) & ~ptrdiff_t(0x3F));
+                    d.data = data;
+                    data += d.numBlocks * d.blockSize;
+                }
+            }
+            return data <= end;
+        }
+
+        bool loadTable(TableEntry& e, TableFile& f, TableType type) {
+            std::string fileName = e.name + (type == WDL ? ".rtbw" : ".rtbz");
+            for (const std::string& directory : directories) {
+                if (f.file.open(directory + "/" + fileName)) {
+                    break;
+                }
+            }
+            // Tables are padded to 16 bytes past a 64 byte boundary
+            if (!f.file.isOpen() || f.file.size() % 64 != 16 || readLE32(f.file.data()) != (type == WDL ? TB_WDL_MAGIC : TB_DTZ_MAGIC)) {
+                return false;
+            }
+            return parseTable(e, f, type);
+        }
+
+        // Maps a table the first time any thread needs it. Loading is serialized, the flag
+        // is published last so a thread that sees it ready sees the whole table.
+        TableFile* mapped(TableEntry& e, TableType type) {
+            TableFile& f = e.files[type];
+            if (!f.ready.load(std::memory_order_acquire)) {
+                std::lock_guard<std::mutex> lock(loadMutex);
+                if (!f.ready.load(std::memory_order_relaxed)) {
+                    f.loaded = loadTable(e, f, type);
+                    if (!f.loaded) {
+                        f.file.close();
+                    }
+                    f.ready.store(true, std::memory_order_release);
+                }
+            }
+            return f.loaded ? &f : nullptr;
+        }
+
+        // Value at an index. The sparse index gives a block near the value, the block
+        // lengths walk to the right one, then its codes are read up to the symbol holding
+        // the value and the symbol is expanded down the pair tree.
+        int decompressPairs(const PairsData& d, uint64_t idx) {
+            if (d.flags & TB_SINGLE_VALUE) {
+                return d.minSymLen;
+            }
+
+            uint64_t k = idx / d.span;
+            uint32_t block = readLE32(d.sparseIndex + 6 * k);
+            int offset = readLE16(d.sparseIndex + 6 * k + 4);
+            // Entry k is for value k * span + span / 2
+            offset += int(idx % d.span) - int(d.span / 2);
+            while (offset < 0) {
+                offset += readLE16(d.blockLength + 2 * --block) + 1;
+            }
+            while (offset > readLE16(d.blockLength + 2 * block)) {
+                offset -= readLE16(d.blockLength + 2 * block++) + 1;
+            }
+
+            const uint8_t* ptr = d.data + block * d.blockSize;
+            uint64_t buf64 = uint64_t(readBE32(ptr)) << 32 | readBE32(ptr + 4);
+            ptr += 8;
+            int buf64Size = 64;
+            int sym;
+            while (true) {
+                int len = 0;
+                while (buf64 < d.base64[len]) {
+                    len++;
+                }
+                sym = int((buf64 - d.base64[len]) >> (64 - len - d.minSymLen));
+                sym += readLE16(d.lowestSym + 2 * len);
+                if (offset < d.symLen[sym] + 1) {
+                    break;
+                }
+                offset -= d.symLen[sym] + 1;
+                len += d.minSymLen;
+                buf64 <<= len;
+                buf64Size -= len;
+                if (buf64Size <= 32) {
+                    buf64Size += 32;
+                    buf64 |= uint64_t(readBE32(ptr)) << (64 - buf64Size);
+                    ptr += 4;
+                }
+            }
+
+            // Pairs are adjacent values, so the offset tells which side holds the value
+            while (d.symLen[sym]) {
+                int left = leftSymbol(d, sym);
+                if (offset < d.symLen[left] + 1) {
+                    sym = left;
+                }
+                else {
+                    offset -= d.symLen[left] + 1;
+                    sym = rightSymbol(d, sym);
+                }
+            }
+            return leftSymbol(d, sym);
+        }
+
+        // DTZ values are stored in moves or plies per result, and may go through a map
+        int mapDtz(const TableFile& f, const PairsData& d, int value, int wdl) {
+            constexpr int WDL_MAP[] = { 1, 3, 0, 2, 0 };
+            if (d.flags & TB_MAPPED) {
+                int idx = d.mapIdx[WDL_MAP[wdl + 2]] + value;
+                value = d.flags & TB_WIDE ? readLE16(f.map + 2 * idx) : f.map[idx];
+            }
+            if ((wdl == WDL_WIN && !(d.flags & TB_WIN_PLIES)) || (wdl == WDL_LOSS && !(d.flags & TB_LOSS_PLIES))
+                || wdl == WDL_CURSED_WIN || wdl == WDL_BLESSED_LOSS) {
+                value *= 2;
+            }
+            return value + 1;
+        }
+
+        bool fileExists(const std::string& path) {
+            std::FILE* f = std::fopen(path.c_str(), "rb");
+            if (f) {
+                std::fclose(f);
+            }
+            return f != nullptr;
+        }
+
+        // Registers a table if its WDL file is in one of the directories
+        void addTable(const std::string& white, const std::string& black) {
+            int counts[COLOR_NB][PIECE_TYPE_NB] = {};
+            for (int c = 0; c < COLOR_NB; c++) {
+                for (char ch : c == WHITE ? white : black) {
+                    counts[c][std::find(PIECE_CHARS, PIECE_CHARS + 6, ch) - PIECE_CHARS]++;
+                }
+            }
+            uint64_t key = materialKey(counts, false);
+            if (entryByKey.count(key)) {
+                return;
+            }
+
+            std::string name = white + "v" + black;
+            bool found = false;
+            for (const std::string& directory : directories) {
+                found = found || fileExists(directory + "/" + name + ".rtbw");
+            }
+            if (!found) {
+                return;
+            }
+
+            TableEntry& e = entries.emplace_back();
+            e.name = name;
+            e.key = key;
+            e.key2 = materialKey(counts, true);
+            e.material.pieceCount = int(white.size() + black.size());
+            e.material.hasPawns = counts[WHITE][PAWN] || counts[BLACK][PAWN];
+            for (int c = 0; c < COLOR_NB; c++) {
+                for (int pt = PAWN; pt < KING; pt++) {
+                    e.material.hasUniquePieces = e.material.hasUniquePieces || counts[c][pt] == 1;
+                }
+            }
+            // Both sides with pawns: the side with fewer leads, it compresses better
+            bool whiteLeads = !counts[BLACK][PAWN] || (counts[WHITE][PAWN] && counts[BLACK][PAWN] >= counts[WHITE][PAWN]);
+            e.material.pawnCount[0] = counts[whiteLeads ? WHITE : BLACK][PAWN];
+            e.material.pawnCount[1] = counts[whiteLeads ? BLACK : WHITE][PAWN];
+
+            entryByKey[e.key] = &e;
+            entryByKey[e.key2] = &e;
+            maxPieces = std::max(maxPieces, e.material.pieceCount);
+        }
+
+        // Every multiset of non-king pieces up to a size, strongest piece first as in the file names
+        void pieceSets(std::string prefix, int maxType, int remaining, std::vector<std::string>& out) {
+            out.push_back(prefix);
+            if (!remaining) {
+                return;
+            }
+            for (int pt = maxType; pt >= PAWN; pt--) {
+                pieceSets(prefix + PIECE_CHARS[pt], pt, remaining - 1, out);
+            }
+        }
+    }
+
+    void init(const std::string& paths) {
+        initEncoding();
+        entries.clear();
+        entryByKey.clear();
+        directories.clear();
+        maxPieces = 0;
+        tablePaths = paths;
+
+#if defined(_WIN32)
+        const char separator = ';';
+#else
+        const char separator = ':';
+#endif
+        size_t start = 0;
+        while (start <= paths.size()) {
+            size_t stop = std::min(paths.find(separator, start), paths.size());
+            if (stop > start) {
+                directories.push_back(paths.substr(start, stop - start));
+            }
+            start = stop + 1;
+        }
+        if (directories.empty()) {
+            return;
+        }
+
+        // Each material is named once, with the stronger side first, so both orders are tried
+        std::vector<std::string> sets;
+        pieceSets("", QUEEN, TB_PIECES - 2, sets);
+        for (const std::string& white : sets) {
+            for (const std::string& black : sets) {
+                if (!white.empty() && white.size() + black.size() <= TB_PIECES - 2) {
+                    addTable("K" + white, "K" + black);
+                }
+            }
+        }
+    }
+
+    const std::string& getPaths() {
+        return tablePaths;
+    }
+
+    int getMaxPieces() {
+        return maxPieces;
+    }
+
+    int getTableCount() {
+        return int(entries.size());
+    }
+}
+
+// ======================
+// Probing
+// ======================
+
+namespace tablebase {
+
+    namespace {
+        // CHANGE_STM: the DTZ table stores the other side to move. ZEROING_BEST_MOVE: the best
+        // move is a capture or pawn move, the table value may be a "don't care" then.
+        enum ProbeState { PROBE_FAIL, PROBE_OK, PROBE_CHANGE_STM, PROBE_ZEROING_BEST_MOVE };
+
+        int signOf(int value) {
+            return (value > 0) - (value < 0);
+        }
+
+        bool canProbe(const Position& position) {
+            return maxPieces && !position.getCastlingRights() && popcount(position.getOccupied()) <= maxPieces;
+        }
+
+        int probeTable(const Position& position, TableType type, ProbeState& state, int wdl = WDL_DRAW) {
+            if (popcount(position.getOccupied()) == 2) {
+                return WDL_DRAW;
+            }
+
+            uint64_t key = materialKey(position);
+            auto it = entryByKey.find(key);
+            TableFile* f = it == entryByKey.end() ? nullptr : mapped(*it->second, type);
+            if (!f) {
+                state = PROBE_FAIL;
+                return 0;
+            }
+            const TableEntry& e = *it->second;
+
+            // Tables are stored with the side named first as white. A symmetric table only
+            // has white to move, positions with black to move are looked up flipped too.
+            Color us = position.getSideToMove();
+            bool flip = (e.key == e.key2 && us == BLACK) || key != e.key;
+            int flipSquares = flip ? 56 : 0;
+            int stm = int(flip) ^ int(us);
+
+            int squares[TB_PIECES];
+            uint8_t pieces[TB_PIECES];
+            int size = 0;
+            int leadPawns = 0;
+            int file = 0;
+            Bitboard leadPawnsBB = 0;
+            if (e.material.hasPawns) {
+                uint8_t lead = f->sides[0][0].layout.pieces[0];
+                Bitboard b = leadPawnsBB = position.getPieces(Color(filePieceColor(lead) ^ flip), PAWN);
+                while (b) {
+                    squares[size] = popLsb(b) ^ flipSquares;
+                    pieces[size++] = lead;
+                }
+                leadPawns = size;
+                file = leadPawnFile(squares, leadPawns);
+            }
+
+            // DTZ tables only store one side to move
+            if (type == DTZ && (f->sides[0][file].flags & TB_STM) != stm && !(e.key == e.key2 && !e.material.hasPawns)) {
+                state = PROBE_CHANGE_STM;
+                return 0;
+            }
+
+            Bitboard b = position.getOccupied() ^ leadPawnsBB;
+            while (b) {
+                int sq = popLsb(b);
+                PieceCode pc = position.pieceOn(sq);
+                squares[size] = sq ^ flipSquares;
+                pieces[size++] = filePiece(Color(colorOf(pc) ^ flip), typeOf(pc));
+            }
+
+            const PairsData& d = f->sides[type == WDL ? stm : 0][file];
+            int value = decompressPairs(d, encode(e.material, d.layout, squares, pieces, size, leadPawns));
+            return type == WDL ? value - 2 : mapDtz(*f, d, value, wdl);
+        }
+
+        // Tables may store anything for positions where a capture wins, and a loss where a
+        // capture draws, so the captures (and for DTZ the pawn moves) are searched first
+        int searchWdl(Position& position, ProbeState& state, bool checkZeroingMoves) {
+            int bestValue = WDL_LOSS;
+            MoveList moves;
+            generateMoves(position, moves);
+            int moveCount = 0;
+            for (Move move : moves) {
+                if (!move.isCapture() && (!checkZeroingMoves || typeOf(position.pieceOn(move.getFrom())) != PAWN)) {
+                    continue;
+                }
+                moveCount++;
+                position.makeMove(move);
+                int value = -searchWdl(position, state, false);
+                position.unmakeMove();
+                if (state == PROBE_FAIL) {
+                    return WDL_DRAW;
+                }
+                if (value > bestValue) {
+                    bestValue = value;
+                    if (value >= WDL_WIN) {
+                        state = PROBE_ZEROING_BEST_MOVE;
+                        return value;
+                    }
+                }
+            }
+
+            // With every move searched the table is not needed, it could even be wrong
+            bool noMoreMoves = moveCount && moveCount == moves.size();
+            int value = bestValue;
+            if (!noMoreMoves) {
+                value = probeTable(position, WDL, state);
+                if (state == PROBE_FAIL) {
+                    return WDL_DRAW;
+                }
+            }
+            if (bestValue >= value) {
+                state = bestValue > WDL_DRAW || noMoreMoves ? PROBE_ZEROING_BEST_MOVE : PROBE_OK;
+                return bestValue;
+            }
+            state = PROBE_OK;
+            return value;
+        }
+
+        // Distance of a position whose best move zeroes the counter
+        int dtzBeforeZeroing(int wdl) {
+            return wdl == WDL_WIN ? 1 : wdl == WDL_CURSED_WIN ? 101 : wdl == WDL_BLESSED_LOSS ? -101 : wdl == WDL_LOSS ? -1 : 0;
+        }
+
+        int searchDtz(Position& position, ProbeState& state) {
+            state = PROBE_OK;
+            int wdl = searchWdl(position, state, true);
+            if (state == PROBE_FAIL || wdl == WDL_DRAW) {
+                return 0;
+            }
+            if (state == PROBE_ZEROING_BEST_MOVE) {
+                return dtzBeforeZeroing(wdl);
+            }
+
+            int dtz = probeTable(position, DTZ, state, wdl);
+            if (state == PROBE_FAIL) {
+                return 0;
+            }
+            if (state != PROBE_CHANGE_STM) {
+                return (dtz + 100 * (wdl == WDL_BLESSED_LOSS || wdl == WDL_CURSED_WIN)) * signOf(wdl);
+            }
+
+            // The table is for the other side to move: one ply further, keep the best
+            // distance among the moves that keep the result
+            int minDtz = 0xFFFF;
+            MoveList moves;
+            generateMoves(position, moves);
+            for (Move move : moves) {
+                bool zeroing = move.isCapture() || typeOf(position.pieceOn(move.getFrom())) == PAWN;
+                position.makeMove(move);
+                dtz = zeroing ? -dtzBeforeZeroing(searchWdl(position, state, false)) : -searchDtz(position, state);
+
+                // A mate is as good as a zeroing move
+                if (dtz == 1 && position.isInCheck()) {
+                    MoveList replies;
+                    generateMoves(position, replies);
+                    if (replies.empty()) {
+                        minDtz = 1;
+                    }
+                }
+                if (!zeroing) {
+                    dtz += signOf(dtz);
+                }
+                if (dtz < minDtz && signOf(dtz) == signOf(wdl)) {
+                    minDtz = dtz;
+                }
+                position.unmakeMove();
+                if (state == PROBE_FAIL) {
+                    return 0;
+                }
+            }
+            return minDtz == 0xFFFF ? -1 : minDtz;
+        }
+    }
+
+    bool probeWdl(Position& position, Wdl& wdl) {
+        if (!canProbe(position)) {
+            return false;
+        }
+        ProbeState state = PROBE_OK;
+        int value = searchWdl(position, state, false);
+        if (state == PROBE_FAIL) {
+            return false;
+        }
+        wdl = Wdl(value);
+        return true;
+    }
+
+    bool probeDtz(Position& position, int& dtz) {
+        if (!canProbe(position)) {
+            return false;
+        }
+        ProbeState state = PROBE_OK;
+        int value = searchDtz(position, state);
+        if (state == PROBE_FAIL) {
+            return false;
+        }
+        dtz = value;
+        return true;
+    }
+
+    bool filterRootMoves(Position& position, MoveList& moves) {
+        if (!canProbe(position) || moves.empty()) {
+            return false;
+        }
+
+        // Wins that zero the counter soonest first, then wins the fifty-move rule may
+        // spoil, draws, losses it may save, and the longest losses
+        int halfmoves = position.getHalfmoveClock();
+        int ranks[MAX_MOVES];
+        bool ranked = true;
+        ProbeState state = PROBE_OK;
+        for (int i = 0; i < moves.size() && ranked; i++) {
+            position.makeMove(moves[i]);
+            int dtz;
+            if (position.getHalfmoveClock() == 0) {
+                dtz = dtzBeforeZeroing(-searchWdl(position, state, false));
+            }
+            else if (position.isDraw()) {
+                dtz = 0;
+            }
+            else {
+                dtz = -searchDtz(position, state);
+                dtz += signOf(dtz);
+            }
+            if (dtz == 2 && position.isInCheck()) {
+                MoveList replies;
+                generateMoves(position, replies);
+                if (replies.empty()) {
+                    dtz = 1;
+                }
+            }
+            position.unmakeMove();
+
+            ranked = state != PROBE_FAIL;
+            ranks[i] = dtz > 0 ? (dtz + halfmoves <= 99 ? TB_MAX_DTZ - dtz : 1)
+                : dtz < 0 ? (-dtz + halfmoves <= 99 ? -TB_MAX_DTZ - dtz : -1)
+                : 0;
+        }
+
+        // Without DTZ tables the moves keeping the best result are all kept
+        if (!ranked) {
+            for (int i = 0; i < moves.size(); i++) {
+                position.makeMove(moves[i]);
+                state = PROBE_OK;
+                ranks[i] = -searchWdl(position, state, false);
+                position.unmakeMove();
+                if (state == PROBE_FAIL) {
+                    return false;
+                }
+            }
+        }
+
+        int best = *std::max_element(ranks, ranks + moves.size());
+        MoveList kept;
+        for (int i = 0; i < moves.size(); i++) {
+            if (ranks[i] == best) {
+                kept.add(moves[i]);
+            }
+        }
+        moves = kept;
+        return true;
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include "Position.h"
+#include "MoveGen.h"
+
+// ======================
+// Syzygy endgame tablebases
+// ======================
+// WDL tables give the result of a position under the fifty-move rule, DTZ tables the
+// distance in plies to the next capture, pawn move or mate on the best line. init() only
+// looks for the files, each one is memory-mapped the first time a search thread needs it,
+// and from then on the mapping is shared by every thread.
+
+namespace tablebase {
+
+    // Results from the side to move's point of view. A cursed win is a win that the
+    // fifty-move rule turns into a draw, a blessed loss the loss it saves.
+    enum Wdl : int {
+        WDL_LOSS = -2,
+        WDL_BLESSED_LOSS = -1,
+        WDL_DRAW = 0,
+        WDL_CURSED_WIN = 1,
+        WDL_WIN = 2
+    };
+
+    // Looks for tables in a list of directories separated by ':' (';' on Windows), an empty
+    // list drops the tables. Must not be called while a search is running, nor before attacks::init().
+    void init(const std::string& paths);
+    const std::string& getPaths();
+
+    // Most pieces of a table found, 0 without tables
+    int getMaxPieces();
+    int getTableCount();
+
+    // Probes fail when a table is missing or does not load, and for positions with castling
+    // rights or more pieces than any table. The position is played into and back out of.
+    bool probeWdl(Position& position, Wdl& wdl);
+    // Positive when the side to move wins, zero for draws
+    bool probeDtz(Position& position, int& dtz);
+
+    // Keeps the root moves that best preserve the tablebase result: DTZ ranking when the
+    // DTZ tables are there, the winning moves that zero the counter soonest first, else the
+    // moves with the best WDL. Returns false and leaves the list as it was if it cannot probe.
+    bool filterRootMoves(Position& position, MoveList& moves);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include "Bitboard.h"
+
+// ======================
+// Syzygy table format, shared by the prober and the table generator
+// ======================
+// A table file holds one compressed value per index. Every position of the table's material
+// maps to an index: colors are flipped so the side named first in the file name is white,
+// the board is mirrored so the leading piece (or the leading pawn) lands in a canonical
+// corner, and then each group of pieces is encoded as a combination of the free squares.
+// Tables with pawns are split in four by the file of the leading pawn.
+
+#define TB_PIECES 7 // Most pieces the encoding handles, kings included
+#define TB_WDL_MAGIC 0x5D23E871 // First four bytes of a file, little endian
+#define TB_DTZ_MAGIC 0xA50C66D7
+#define TB_MAX_DTZ 0x40000 // Above any distance a table can store, used to rank root moves
+
+namespace tablebase {
+
+    // Per side table flags
+    enum TableFlag : uint8_t {
+        TB_STM = 1,          // DTZ: the side to move the table is for
+        TB_MAPPED = 2,       // DTZ: values go through a per result map
+        TB_WIN_PLIES = 4,    // DTZ: wins are counted in plies, otherwise in moves
+        TB_LOSS_PLIES = 8,
+        TB_WIDE = 16,        // DTZ: the map holds 16 bit values
+        TB_SINGLE_VALUE = 128 // Every index holds the same value, nothing is compressed
+    };
+
+    // File header flags
+    constexpr uint8_t TB_SPLIT = 1;     // WDL: both sides to move are stored
+    constexpr uint8_t TB_HAS_PAWNS = 2;
+
+    // Piece codes used in the files: pawn to king are 1 to 6 for white, 9 to 14 for black
+    inline uint8_t filePiece(Color c, PieceType pt) {
+        return uint8_t((pt + 1) | (c == BLACK ? 8 : 0));
+    }
+
+    inline PieceType filePieceType(uint8_t piece) {
+        return PieceType((piece & 7) - 1);
+    }
+
+    inline Color filePieceColor(uint8_t piece) {
+        return piece & 8 ? BLACK : WHITE;
+    }
+
+    // What the index encoding needs to know about a table's material
+    struct TableMaterial {
+        int pieceCount = 0;
+        bool hasPawns = false;
+        bool hasUniquePieces = false; // At least one piece other than a king is alone of its kind
+        int pawnCount[2] = { 0, 0 };  // Leading color first, the one with fewer pawns
+    };
+
+    // Index layout of one side (and one leading pawn file) of a table. The piece order comes
+    // from the file and defines the groups, consecutive equal pieces are encoded together.
+    struct TableLayout {
+        uint8_t pieces[TB_PIECES] = {};
+        int groupLen[TB_PIECES + 1] = {};      // Zero terminated
+        uint64_t groupIdx[TB_PIECES + 1] = {}; // Multiplier of each group, the last one is the table size
+
+        uint64_t size() const;
+    };
+
+    // Builds the encoding tables after attacks::init(), safe to call more than once
+    void initEncoding();
+
+    // Fills the groups of a layout whose pieces are set. order[0] is the rank of the leading
+    // group in the index, order[1] the one of the other color's pawns (0xF without).
+    void setGroups(const TableMaterial& material, TableLayout& layout, const int order[2], int file);
+
+    // Moves the leading pawn, the one closest to the a or h file and then to rank 2, to the
+    // front of the first count squares and returns its file folded to a..d
+    int leadPawnFile(int* squares, int count);
+
+    // Index of a position. squares and pieces hold every piece, colors and squares already
+    // flipped to the table's point of view, the leadPawns pawns of the leading color first
+    // with the leading one in front. Both arrays are reordered and mirrored in place.
+    uint64_t encode(const TableMaterial& material, const TableLayout& layout, int* squares, uint8_t* pieces, int count, int leadPawns);
+}
@@ -0,0 +1,1244 @@
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+#include "Attacks.h"
+#include "Position.h"
+#include "Tablebase.h"
+#include "TablebaseFormat.h"
+
+// Syzygy table generator for the small endings
+//   tbgen DIR NAME... [--verify]
+//       solves each material (KRvK, KPvKP, ...) together with every ending it converts into
+//       and writes the .rtbw and .rtbz files of all of them to DIR. --verify then loads the tables
+//       with the engine's prober and compares its WDL and DTZ with the solver's on every
+//       position, or on a fixed random sample of the larger tables.
+// Tables are solved whole in memory, which is what limits the generator to four pieces.
+// The files use the Syzygy layout and index encoding, the compression is simpler than the
+// real generator's: one Huffman code per value, no pair symbols, no DTZ maps.
+
+#define GEN_MAX_PIECES 4
+#define GEN_BLOCK_LOG 6      // 64 byte compressed blocks
+#define GEN_BLOCK_PAYLOAD 56 // Bytes of codes per block, the decoder reads up to 8 past the last one
+#define GEN_SPAN_LOG 10      // One sparse index entry every 1024 values
+#define GEN_MAX_CODE_LEN 32
+#define VERIFY_SAMPLE 200000 // Positions checked per table by --verify
+
+using namespace tablebase;
+
+namespace {
+    const char PIECE_CHARS[] = "PNBRQK";
+    const int8_t WDL_NONE = INT8_MIN;
+    const int16_t DTZ_NONE = INT16_MIN;
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    Bitboard pieceAttacks(Color c, PieceType pt, int sq, Bitboard occupied) {
+        switch (pt) {
+        case PAWN:
+            return attacks::pawnAttacks(c, sq);
+        case KNIGHT:
+            return attacks::knightAttacks(sq);
+        case BISHOP:
+            return attacks::bishopAttacks(sq, occupied);
+        case ROOK:
+            return attacks::rookAttacks(sq, occupied);
+        case QUEEN:
+            return attacks::queenAttacks(sq, occupied);
+        default:
+            return attacks::kingAttacks(sq);
+        }
+    }
+
+    // ======================
+    // Positions
+    // ======================
+
+    // A handful of pieces in slots. While a material is solved the slots keep their order,
+    // which is what the position's state number is made of.
+    struct GenBoard {
+        int count = 0;
+        Color color[GEN_MAX_PIECES] = {};
+        PieceType type[GEN_MAX_PIECES] = {};
+        int square[GEN_MAX_PIECES] = {};
+        Color sideToMove = WHITE;
+
+        Bitboard occupied() const {
+            Bitboard b = 0;
+            for (int i = 0; i < count; i++) {
+                b |= squareBB(square[i]);
+            }
+            return b;
+        }
+
+        Bitboard colorBB(Color c) const {
+            Bitboard b = 0;
+            for (int i = 0; i < count; i++) {
+                if (color[i] == c) {
+                    b |= squareBB(square[i]);
+                }
+            }
+            return b;
+        }
+
+        int slotOn(int sq) const {
+            for (int i = 0; i < count; i++) {
+                if (square[i] == sq) {
+                    return i;
+                }
+            }
+            return -1;
+        }
+
+        int kingSquare(Color c) const {
+            for (int i = 0; i < count; i++) {
+                if (color[i] == c && type[i] == KING) {
+                    return square[i];
+                }
+            }
+            return NO_SQUARE;
+        }
+
+        void remove(int slot) {
+            for (int i = slot; i < count - 1; i++) {
+                color[i] = color[i + 1];
+                type[i] = type[i + 1];
+                square[i] = square[i + 1];
+            }
+            count--;
+        }
+
+        bool attacked(int sq, Color by) const {
+            Bitboard occ = occupied();
+            for (int i = 0; i < count; i++) {
+                if (color[i] == by && (pieceAttacks(by, type[i], square[i], occ) & squareBB(sq))) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool inCheck() const {
+            return attacked(kingSquare(sideToMove), Color(sideToMove ^ 1));
+        }
+
+        // Pieces on distinct squares and the side that just moved not in check
+        bool legal() const {
+            if (popcount(occupied()) != count) {
+                return false;
+            }
+            return !attacked(kingSquare(Color(sideToMove ^ 1)), sideToMove);
+        }
+
+        std::string fen() const {
+            char board[64];
+            std::fill(board, board + 64, '.');
+            for (int i = 0; i < count; i++) {
+                char ch = PIECE_CHARS[type[i]];
+                board[square[i]] = color[i] == WHITE ? ch : char(ch - 'A' + 'a');
+            }
+            std::string s;
+            for (int rank = 7; rank >= 0; rank--) {
+                int empty = 0;
+                for (int file = 0; file < 8; file++) {
+                    char ch = board[makeSquare(file, rank)];
+                    if (ch == '.') {
+                        empty++;
+                        continue;
+                    }
+                    if (empty) {
+                        s += char('0' + empty);
+                        empty = 0;
+                    }
+                    s += ch;
+                }
+                if (empty) {
+                    s += char('0' + empty);
+                }
+                if (rank) {
+                    s += '/';
+                }
+            }
+            return s + (sideToMove == WHITE ? " w - - 0 1" : " b - - 0 1");
+        }
+    };
+
+    struct GenMove {
+        int slot;
+        int to;
+        PieceType promotion; // PAWN without one
+        bool capture;
+        bool doublePush;
+    };
+
+    struct GenMoveList {
+        GenMove moves[96];
+        int size = 0;
+    };
+
+    GenBoard playMove(const GenBoard& b, const GenMove& move) {
+        GenBoard child = b;
+        int victim = move.capture ? b.slotOn(move.to) : -1;
+        child.square[move.slot] = move.to;
+        if (move.promotion != PAWN) {
+            child.type[move.slot] = move.promotion;
+        }
+        if (victim >= 0) {
+            child.remove(victim);
+        }
+        child.sideToMove = Color(b.sideToMove ^ 1);
+        return child;
+    }
+
+    // Legal moves. Positions in tables never have en passant rights, double pushes are
+    // flagged so the caller can look at the replies that capture en passant.
+    void generateMoves(const GenBoard& b, GenMoveList& list) {
+        list.size = 0;
+        Color us = b.sideToMove;
+        Bitboard occ = b.occupied();
+        Bitboard own = b.colorBB(us);
+        Bitboard enemy = occ & ~own;
+        auto add = [&](int slot, int to, PieceType promotion, bool capture, bool doublePush) {
+            GenMove move = { slot, to, promotion, capture, doublePush };
+            if (playMove(b, move).legal()) {
+                list.moves[list.size++] = move;
+            }
+        };
+
+        for (int i = 0; i < b.count; i++) {
+            if (b.color[i] != us) {
+                continue;
+            }
+            int from = b.square[i];
+            if (b.type[i] != PAWN) {
+                Bitboard targets = pieceAttacks(us, b.type[i], from, occ) & ~own;
+                while (targets) {
+                    int to = popLsb(targets);
+                    add(i, to, PAWN, bool(enemy & squareBB(to)), false);
+                }
+                continue;
+            }
+
+            int forward = us == WHITE ? 8 : -8;
+            bool promotes = rankOf(from) == (us == WHITE ? 6 : 1);
+            Bitboard targets = attacks::pawnAttacks(us, from) & enemy;
+            if (!(occ & squareBB(from + forward))) {
+                targets |= squareBB(from + forward);
+                int start = us == WHITE ? 1 : 6;
+                if (rankOf(from) == start && !(occ & squareBB(from + 2 * forward))) {
+                    add(i, from + 2 * forward, PAWN, false, true);
+                }
+            }
+            while (targets) {
+                int to = popLsb(targets);
+                bool capture = bool(enemy & squareBB(to));
+                if (promotes) {
+                    for (int pt = QUEEN; pt >= KNIGHT; pt--) {
+                        add(i, to, PieceType(pt), capture, false);
+                    }
+                }
+                else {
+                    add(i, to, PAWN, capture, false);
+                }
+            }
+        }
+    }
+
+    // ======================
+    // Materials
+    // ======================
+
+    struct Material {
+        int counts[COLOR_NB][PIECE_TYPE_NB] = {};
+
+        int pieceCount() const {
+            int n = 0;
+            for (int c = 0; c < COLOR_NB; c++) {
+                for (int pt = 0; pt < PIECE_TYPE_NB; pt++) {
+                    n += counts[c][pt];
+                }
+            }
+            return n;
+        }
+
+        bool operator==(const Material& other) const {
+            return !memcmp(counts, other.counts, sizeof(counts));
+        }
+
+        Material swapped() const {
+            Material m;
+            for (int pt = 0; pt < PIECE_TYPE_NB; pt++) {
+                m.counts[WHITE][pt] = counts[BLACK][pt];
+                m.counts[BLACK][pt] = counts[WHITE][pt];
+            }
+            return m;
+        }
+
+        // White first, strongest piece first: KRPvKB
+        std::string name() const {
+            std::string s;
+            for (int c = 0; c < COLOR_NB; c++) {
+                if (c) {
+                    s += 'v';
+                }
+                for (int pt = KING; pt >= PAWN; pt--) {
+                    s += std::string(counts[c][pt], PIECE_CHARS[pt]);
+                }
+            }
+            return s;
+        }
+
+        // The side with more material is white in a table, and the choice has to be the
+        // same everywhere: by value, then by number of pieces, then by the heavier pieces
+        bool isCanonical() const {
+            const int VALUES[PIECE_TYPE_NB] = { 1, 3, 3, 5, 9, 0 };
+            int value[COLOR_NB] = {};
+            int pieces[COLOR_NB] = {};
+            for (int c = 0; c < COLOR_NB; c++) {
+                for (int pt = 0; pt < PIECE_TYPE_NB; pt++) {
+                    value[c] += VALUES[pt] * counts[c][pt];
+                    pieces[c] += counts[c][pt];
+                }
+            }
+            if (value[WHITE] != value[BLACK]) {
+                return value[WHITE] > value[BLACK];
+            }
+            if (pieces[WHITE] != pieces[BLACK]) {
+                return pieces[WHITE] > pieces[BLACK];
+            }
+            for (int pt = QUEEN; pt >= PAWN; pt--) {
+                if (counts[WHITE][pt] != counts[BLACK][pt]) {
+                    return counts[WHITE][pt] > counts[BLACK][pt];
+                }
+            }
+            return true;
+        }
+
+        Material canonical() const {
+            return isCanonical() ? *this : swapped();
+        }
+    };
+
+    Material materialOf(const GenBoard& b) {
+        Material m;
+        for (int i = 0; i < b.count; i++) {
+            m.counts[b.color[i]][b.type[i]]++;
+        }
+        return m;
+    }
+
+    bool parseName(const std::string& name, Material& m) {
+        size_t v = name.find('v');
+        if (v == std::string::npos || name[0] != 'K' || v + 1 >= name.size() || name[v + 1] != 'K') {
+            return false;
+        }
+        for (size_t i = 0; i < name.size(); i++) {
+            if (i == v) {
+                continue;
+            }
+            const char* p = strchr(PIECE_CHARS, name[i]);
+            if (!p || !*p) {
+                return false;
+            }
+            m.counts[i < v ? WHITE : BLACK][p - PIECE_CHARS]++;
+        }
+        return m.counts[WHITE][KING] == 1 && m.counts[BLACK][KING] == 1 && m.pieceCount() <= GEN_MAX_PIECES;
+    }
+
+    // Every material one capture or promotion away
+    std::vector<Material> childMaterials(const Material& m) {
+        std::vector<Material> children;
+        for (int c = 0; c < COLOR_NB; c++) {
+            for (int pt = PAWN; pt < KING; pt++) {
+                if (m.counts[c][pt]) {
+                    Material child = m;
+                    child.counts[c][pt]--;
+                    children.push_back(child);
+                }
+            }
+            if (!m.counts[c][PAWN]) {
+                continue;
+            }
+            for (int promotion = KNIGHT; promotion <= QUEEN; promotion++) {
+                Material child = m;
+                child.counts[c][PAWN]--;
+                child.counts[c][promotion]++;
+                children.push_back(child);
+                for (int pt = KNIGHT; pt < KING; pt++) {
+                    if (child.counts[c ^ 1][pt]) {
+                        Material capture = child;
+                        capture.counts[c ^ 1][pt]--;
+                        children.push_back(capture);
+                    }
+                }
+            }
+        }
+        return children;
+    }
+
+    // ======================
+    // Solved tables
+    // ======================
+
+    // A solved material in its table's own index space, white being the side named first
+    struct SolvedTable {
+        Material material;
+        bool symmetric = false;
+        TableMaterial tableMaterial;
+        uint8_t pieces[TB_PIECES] = {};
+        int fileCount = 1;
+        TableLayout layouts[4];
+        std::vector<int8_t> wdl[COLOR_NB][4]; // By side to move and leading pawn file
+        std::vector<int16_t> dtz[COLOR_NB][4];
+    };
+
+    // Position checked against the prober by --verify
+    struct Sample {
+        std::string fen;
+        int wdl;
+        int dtz;
+    };
+
+    std::map<std::string, std::unique_ptr<SolvedTable>> solvedTables;
+    std::map<std::string, std::vector<Sample>> verifySamples; // Keyed by the tables to verify
+
+    // Piece order of the files: the leading pawns and the other pawns first, else both kings
+    // and a unique piece, which the encoding places together, then the rest in groups
+    void setLayout(SolvedTable& t) {
+        const Material& m = t.material;
+        TableMaterial& tm = t.tableMaterial;
+        tm.pieceCount = m.pieceCount();
+        tm.hasPawns = m.counts[WHITE][PAWN] || m.counts[BLACK][PAWN];
+        for (int c = 0; c < COLOR_NB; c++) {
+            for (int pt = PAWN; pt < KING; pt++) {
+                tm.hasUniquePieces = tm.hasUniquePieces || m.counts[c][pt] == 1;
+            }
+        }
+        bool whiteLeads = !m.counts[BLACK][PAWN] || (m.counts[WHITE][PAWN] && m.counts[BLACK][PAWN] >= m.counts[WHITE][PAWN]);
+        Color lead = whiteLeads ? WHITE : BLACK;
+        tm.pawnCount[0] = m.counts[lead][PAWN];
+        tm.pawnCount[1] = m.counts[lead ^ 1][PAWN];
+
+        int n = 0;
+        int left[COLOR_NB][PIECE_TYPE_NB];
+        memcpy(left, m.counts, sizeof(left));
+        auto take = [&](Color c, PieceType pt, int count) {
+            for (int i = 0; i < count; i++) {
+                t.pieces[n++] = filePiece(c, pt);
+            }
+            left[c][pt] -= count;
+        };
+        take(lead, PAWN, left[lead][PAWN]);
+        take(Color(lead ^ 1), PAWN, left[lead ^ 1][PAWN]);
+        take(WHITE, KING, 1);
+        take(BLACK, KING, 1);
+        if (!tm.hasPawns && tm.hasUniquePieces) {
+            bool found = false;
+            for (int pt = QUEEN; pt > PAWN && !found; pt--) {
+                for (int c = 0; c < COLOR_NB && !found; c++) {
+                    if (left[c][pt] == 1) {
+                        take(Color(c), PieceType(pt), 1);
+                        found = true;
+                    }
+                }
+            }
+        }
+        for (int pt = QUEEN; pt > PAWN; pt--) {
+            for (int c = 0; c < COLOR_NB; c++) {
+                take(Color(c), PieceType(pt), left[c][pt]);
+            }
+        }
+
+        t.symmetric = m == m.swapped();
+        t.fileCount = tm.hasPawns ? 4 : 1;
+        int order[2] = { 0, tm.pawnCount[1] ? 1 : 0xF };
+        for (int file = 0; file < t.fileCount; file++) {
+            memcpy(t.layouts[file].pieces, t.pieces, sizeof(t.pieces));
+            setGroups(tm, t.layouts[file], order, file);
+        }
+    }
+
+    // Index of a position already in the table's orientation, the same computation as the prober's
+    uint64_t tableIndex(const SolvedTable& t, const GenBoard& b, int& file) {
+        int squares[TB_PIECES];
+        uint8_t codes[TB_PIECES];
+        int size = 0;
+        int leadPawns = 0;
+        file = 0;
+        Color lead = filePieceColor(t.pieces[0]);
+        if (t.tableMaterial.hasPawns) {
+            for (int i = 0; i < b.count; i++) {
+                if (b.type[i] == PAWN && b.color[i] == lead) {
+                    squares[size] = b.square[i];
+                    codes[size++] = t.pieces[0];
+                }
+            }
+            leadPawns = size;
+            file = leadPawnFile(squares, leadPawns);
+        }
+        for (int i = 0; i < b.count; i++) {
+            if (!(t.tableMaterial.hasPawns && b.type[i] == PAWN && b.color[i] == lead)) {
+                squares[size] = b.square[i];
+                codes[size++] = filePiece(b.color[i], b.type[i]);
+            }
+        }
+        return encode(t.tableMaterial, t.layouts[file], squares, codes, size, leadPawns);
+    }
+
+    // Result of a position of an already solved material, for its side to move
+    int lookupWdl(const GenBoard& position) {
+        Material m = materialOf(position);
+        GenBoard b = position;
+        if (!m.isCanonical()) {
+            m = m.swapped();
+            for (int i = 0; i < b.count; i++) {
+                b.color[i] = Color(b.color[i] ^ 1);
+                b.square[i] ^= 56;
+            }
+            b.sideToMove = Color(b.sideToMove ^ 1);
+        }
+        const SolvedTable& t = *solvedTables.at(m.name());
+        int file;
+        uint64_t idx = tableIndex(t, b, file);
+        return t.wdl[b.sideToMove][file][idx];
+    }
+
+    int wdlOfDistance(int dtz) {
+        return dtz > 100 ? WDL_CURSED_WIN : dtz > 0 ? WDL_WIN : dtz < -100 ? WDL_BLESSED_LOSS : dtz < 0 ? WDL_LOSS : WDL_DRAW;
+    }
+
+    // ======================
+    // Solver
+    // ======================
+
+    // Retrograde analysis of one material. Non-zeroing moves keep the pawns where they are,
+    // so the positions are cut in slices by pawn placement and each slice is solved on its own:
+    // captures and promotions lead to solved materials, pawn moves to slices solved earlier,
+    // the slices being taken from the most advanced pawns back. Within a slice the distances
+    // are found in increasing order from the positions whose result a zeroing move or mate
+    // decides, as in a DTZ table: mated is -1, mate in one and a winning zeroing move 1.
+    class Solver {
+        enum StateFlag : uint8_t {
+            LEGAL = 1,
+            FINAL = 2,
+            NO_LOSS = 4, // A zeroing move saves the position
+            MATED = 8
+        };
+
+        SolvedTable& table;
+        GenBoard slots; // Pawns first
+        int pawnSlots = 0;
+        int pieceSlots = 0;
+        uint64_t sideSize = 1;
+        uint64_t sliceSize = 0;
+        uint64_t sliceCount = 1;
+
+        std::vector<int16_t> distance; // DTZ of the position once FINAL
+        std::vector<uint8_t> remaining; // Non-zeroing moves not yet known to lose
+        std::vector<uint8_t> zeroLoss;  // Longest DTZ a zeroing move keeps in a lost position
+        std::vector<uint8_t> flags;
+        std::vector<std::vector<uint32_t>> buckets;
+
+        GenBoard decode(uint64_t state) const {
+            GenBoard b = slots;
+            uint64_t slice = state / sliceSize;
+            uint64_t local = state % sliceSize;
+            b.sideToMove = Color(local / sideSize);
+            for (int i = 0; i < pawnSlots; i++) {
+                b.square[i] = int(slice % 48) + 8;
+                slice /= 48;
+            }
+            for (int i = pawnSlots; i < b.count; i++) {
+                b.square[i] = int(local % 64);
+                local /= 64;
+            }
+            return b;
+        }
+
+        uint64_t encodeState(const GenBoard& b) const {
+            uint64_t slice = 0;
+            for (int i = pawnSlots - 1; i >= 0; i--) {
+                slice = slice * 48 + (b.square[i] - 8);
+            }
+            uint64_t local = 0;
+            for (int i = b.count - 1; i >= pawnSlots; i--) {
+                local = local * 64 + b.square[i];
+            }
+            return slice * sliceSize + b.sideToMove * sideSize + local;
+        }
+
+        int advancement(uint64_t slice) const {
+            GenBoard b = decode(slice * sliceSize);
+            int sum = 0;
+            for (int i = 0; i < pawnSlots; i++) {
+                sum += b.color[i] == WHITE ? rankOf(b.square[i]) : 7 - rankOf(b.square[i]);
+            }
+            return sum;
+        }
+
+        // Positions one non-zeroing move before this one
+        template<typename F>
+        void forEachPredecessor(const GenBoard& b, F f) const {
+            Color mover = Color(b.sideToMove ^ 1);
+            Bitboard occ = b.occupied();
+            for (int i = pawnSlots; i < b.count; i++) {
+                if (b.color[i] != mover) {
+                    continue;
+                }
+                Bitboard origins = pieceAttacks(mover, b.type[i], b.square[i], occ) & ~occ;
+                while (origins) {
+                    GenBoard q = b;
+                    q.square[i] = popLsb(origins);
+                    q.sideToMove = mover;
+                    if (q.legal()) {
+                        f(encodeState(q));
+                    }
+                }
+            }
+        }
+
+        // Result of the position after a zeroing move, for the side to move there
+        int zeroingResult(const GenBoard& child, const GenMove& move) const {
+            int wdl = !move.capture && move.promotion == PAWN ? wdlOfDistance(distance[encodeState(child)]) : lookupWdl(child);
+            if (!move.doublePush) {
+                return wdl;
+            }
+
+            // The reply may capture en passant, which the stored result does not know about
+            Color us = child.sideToMove;
+            int epSquare = move.to + (us == WHITE ? 8 : -8);
+            for (int i = 0; i < child.count; i++) {
+                if (child.color[i] != us || child.type[i] != PAWN || rankOf(child.square[i]) != rankOf(move.to)
+                    || std::abs(fileOf(child.square[i]) - fileOf(move.to)) != 1) {
+                    continue;
+                }
+                GenBoard e = child;
+                e.square[i] = epSquare;
+                e.remove(move.slot);
+                e.sideToMove = Color(us ^ 1);
+                if (e.legal()) {
+                    wdl = std::max(wdl, -lookupWdl(e));
+                }
+            }
+            return wdl;
+        }
+
+        void push(uint32_t local, int level) {
+            if (level >= int(buckets.size())) {
+                buckets.resize(level + 1);
+            }
+            buckets[level].push_back(local);
+        }
+
+        void solveSlice(uint64_t slice) {
+            uint64_t base = slice * sliceSize;
+            GenBoard first = decode(base);
+            for (int i = 0; i < pawnSlots; i++) {
+                for (int j = 0; j < i; j++) {
+                    if (first.square[i] == first.square[j]) {
+                        return;
+                    }
+                }
+            }
+            buckets.clear();
+
+            GenMoveList moves;
+            for (uint64_t local = 0; local < sliceSize; local++) {
+                uint64_t s = base + local;
+                GenBoard b = decode(s);
+                if (!b.legal()) {
+                    continue;
+                }
+                flags[s] = LEGAL;
+                generateMoves(b, moves);
+                if (!moves.size) {
+                    bool mated = b.inCheck();
+                    flags[s] |= FINAL | (mated ? MATED : 0);
+                    distance[s] = mated ? -1 : 0;
+                    if (mated) {
+                        push(uint32_t(local), 0);
+                    }
+                    continue;
+                }
+
+                int winLevel = 0;
+                int lossLevel = 0;
+                int count = 0;
+                for (int i = 0; i < moves.size; i++) {
+                    const GenMove& move = moves.moves[i];
+                    if (!move.capture && b.type[move.slot] != PAWN) {
+                        count++;
+                        continue;
+                    }
+                    int result = -zeroingResult(playMove(b, move), move);
+                    if (result == WDL_WIN || result == WDL_CURSED_WIN) {
+                        int level = result == WDL_WIN ? 1 : 101;
+                        winLevel = winLevel ? std::min(winLevel, level) : level;
+                    }
+                    else if (result == WDL_DRAW) {
+                        flags[s] |= NO_LOSS;
+                    }
+                    else {
+                        lossLevel = std::max(lossLevel, result == WDL_LOSS ? 1 : 101);
+                    }
+                }
+                remaining[s] = uint8_t(count);
+                zeroLoss[s] = uint8_t(lossLevel);
+                if (winLevel) {
+                    flags[s] |= NO_LOSS;
+                    push(uint32_t(local), winLevel);
+                }
+                else if (!count && !(flags[s] & NO_LOSS)) {
+                    flags[s] |= FINAL;
+                    distance[s] = int16_t(-lossLevel);
+                    push(uint32_t(local), lossLevel);
+                }
+            }
+
+            // Wins come out of the buckets in increasing distance, a loss is final when its
+            // last move is known to lose and goes in the bucket of its distance
+            for (size_t level = 0; level < buckets.size(); level++) {
+                for (size_t k = 0; k < buckets[level].size(); k++) {
+                    uint64_t s = base + buckets[level][k];
+                    GenBoard b = decode(s);
+                    if (flags[s] & FINAL) {
+                        if (distance[s] > 0) {
+                            continue;
+                        }
+                        int parentLevel = flags[s] & MATED ? 1 : int(level) + 1;
+                        forEachPredecessor(b, [&](uint64_t q) {
+                            if (!(flags[q] & FINAL)) {
+                                push(uint32_t(q - base), parentLevel);
+                            }
+                        });
+                        continue;
+                    }
+
+                    flags[s] |= FINAL;
+                    distance[s] = int16_t(level);
+                    forEachPredecessor(b, [&](uint64_t q) {
+                        if ((flags[q] & FINAL) || --remaining[q] || (flags[q] & NO_LOSS)) {
+                            return;
+                        }
+                        int lossLevel = std::max(int(zeroLoss[q]), int(level) + 1);
+                        flags[q] |= FINAL;
+                        distance[q] = int16_t(-lossLevel);
+                        push(uint32_t(q - base), lossLevel);
+                    });
+                }
+            }
+
+            for (uint64_t s = base; s < base + sliceSize; s++) {
+                if ((flags[s] & LEGAL) && !(flags[s] & FINAL)) {
+                    flags[s] |= FINAL;
+                    distance[s] = 0;
+                }
+            }
+        }
+
+    public:
+        explicit Solver(SolvedTable& table) : table(table) {
+            const Material& m = table.material;
+            for (int pass = 0; pass < 2; pass++) {
+                for (int c = 0; c < COLOR_NB; c++) {
+                    for (int pt = PAWN; pt <= KING; pt++) {
+                        if ((pt == PAWN) != (pass == 0)) {
+                            continue;
+                        }
+                        for (int i = 0; i < m.counts[c][pt]; i++) {
+                            slots.color[slots.count] = Color(c);
+                            slots.type[slots.count++] = PieceType(pt);
+                        }
+                    }
+                }
+                if (!pass) {
+                    pawnSlots = slots.count;
+                }
+            }
+            pieceSlots = slots.count - pawnSlots;
+            for (int i = 0; i < pieceSlots; i++) {
+                sideSize *= 64;
+            }
+            for (int i = 0; i < pawnSlots; i++) {
+                sliceCount *= 48;
+            }
+            sliceSize = 2 * sideSize;
+        }
+
+        void solve() {
+            uint64_t states = sliceSize * sliceCount;
+            distance.assign(states, 0);
+            remaining.assign(states, 0);
+            zeroLoss.assign(states, 0);
+            flags.assign(states, 0);
+
+            std::vector<std::pair<int, uint64_t>> order;
+            for (uint64_t slice = 0; slice < sliceCount; slice++) {
+                order.emplace_back(advancement(slice), slice);
+            }
+            std::stable_sort(order.begin(), order.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+            for (const auto& slice : order) {
+                solveSlice(slice.second);
+            }
+        }
+
+        // Moves the results to the table's index space. Symmetric positions share an index,
+        // two different results on one index would mean a broken encoding.
+        bool store(std::vector<Sample>* samples) {
+            for (int c = 0; c < COLOR_NB; c++) {
+                for (int file = 0; file < table.fileCount; file++) {
+                    uint64_t size = table.layouts[file].size();
+                    table.wdl[c][file].assign(size, WDL_NONE);
+                    table.dtz[c][file].assign(size, DTZ_NONE);
+                }
+            }
+
+            std::mt19937_64 rng(1);
+            uint64_t seen = 0;
+            uint64_t conflicts = 0;
+            for (uint64_t s = 0; s < flags.size(); s++) {
+                if (!(flags[s] & LEGAL)) {
+                    continue;
+                }
+                GenBoard b = decode(s);
+                int file;
+                uint64_t idx = tableIndex(table, b, file);
+                int8_t& wdl = table.wdl[b.sideToMove][file][idx];
+                int16_t& dtz = table.dtz[b.sideToMove][file][idx];
+                if ((wdl != WDL_NONE && wdl != wdlOfDistance(distance[s])) || (dtz != DTZ_NONE && dtz != distance[s])) {
+                    conflicts++;
+                }
+                wdl = int8_t(wdlOfDistance(distance[s]));
+                dtz = distance[s];
+
+                // Reservoir sample, every position while there are few
+                if (samples) {
+                    uint64_t j = seen < VERIFY_SAMPLE ? seen : rng() % (seen + 1);
+                    if (seen < VERIFY_SAMPLE) {
+                        samples->push_back({ b.fen(), wdl, dtz });
+                    }
+                    else if (j < VERIFY_SAMPLE) {
+                        (*samples)[j] = { b.fen(), wdl, dtz };
+                    }
+                    seen++;
+                }
+            }
+            if (conflicts) {
+                std::cerr << table.material.name() << ": " << conflicts << " positions disagree with their index" << std::endl;
+            }
+            return !conflicts;
+        }
+
+        uint64_t getLegalCount() const {
+            return uint64_t(std::count_if(flags.begin(), flags.end(), [](uint8_t f) { return f & LEGAL; }));
+        }
+    };
+
+    bool solve(const Material& material) {
+        if (solvedTables.count(material.name())) {
+            return true;
+        }
+        for (const Material& child : childMaterials(material)) {
+            if (!solve(child.canonical())) {
+                return false;
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        auto table = std::make_unique<SolvedTable>();
+        table->material = material;
+        setLayout(*table);
+        Solver solver(*table);
+        solver.solve();
+        auto samples = verifySamples.find(material.name());
+        if (!solver.store(samples == verifySamples.end() ? nullptr : &samples->second)) {
+            return false;
+        }
+        std::cout << "solved " << material.name() << ": " << solver.getLegalCount() << " positions in "
+            << secondsSince(start) << " s" << std::endl;
+        solvedTables[material.name()] = std::move(table);
+        return true;
+    }
+
+    // ======================
+    // Writer
+    // ======================
+
+    void putLE16(std::vector<uint8_t>& out, uint32_t value) {
+        out.push_back(uint8_t(value));
+        out.push_back(uint8_t(value >> 8));
+    }
+
+    void putLE32(std::vector<uint8_t>& out, uint32_t value) {
+        putLE16(out, value & 0xFFFF);
+        putLE16(out, value >> 16);
+    }
+
+    // Huffman code lengths, flattened until the longest fits the format
+    std::vector<int> codeLengths(std::vector<uint64_t> weights) {
+        while (true) {
+            int n = int(weights.size());
+            std::vector<int> parent(2 * n - 1, -1);
+            using Node = std::pair<uint64_t, int>;
+            std::priority_queue<Node, std::vector<Node>, std::greater<Node>> heap;
+            for (int i = 0; i < n; i++) {
+                heap.push({ weights[i], i });
+            }
+            int next = n;
+            while (heap.size() > 1) {
+                Node a = heap.top();
+                heap.pop();
+                Node b = heap.top();
+                heap.pop();
+                parent[a.second] = parent[b.second] = next;
+                heap.push({ a.first + b.first, next++ });
+            }
+
+            std::vector<int> lengths(n);
+            int longest = 0;
+            for (int i = 0; i < n; i++) {
+                for (int j = i; parent[j] >= 0; j = parent[j]) {
+                    lengths[i]++;
+                }
+                longest = std::max(longest, lengths[i]);
+            }
+            if (longest <= GEN_MAX_CODE_LEN) {
+                return lengths;
+            }
+            for (uint64_t& w : weights) {
+                w = (w + 1) / 2;
+            }
+        }
+    }
+
+    // One side of one leading pawn file, laid out as the prober's setSizes reads it
+    struct PackedValues {
+        std::vector<uint8_t> sizes;
+        std::vector<uint8_t> sparseIndex;
+        std::vector<uint8_t> blockLengths;
+        std::vector<uint8_t> blocks;
+    };
+
+    PackedValues pack(const std::vector<uint16_t>& values, uint8_t flags) {
+        PackedValues p;
+        std::map<uint16_t, uint64_t> frequency;
+        for (uint16_t v : values) {
+            frequency[v]++;
+        }
+        if (frequency.size() == 1 && values[0] < 256) {
+            p.sizes = { uint8_t(flags | TB_SINGLE_VALUE), uint8_t(values[0]) };
+            return p;
+        }
+        if (frequency.size() == 1) {
+            frequency[0]; // A second symbol so there is a code at all
+        }
+
+        // Canonical code, the longest codes numbered first
+        std::vector<uint16_t> symbolValue;
+        std::vector<uint64_t> weights;
+        for (const auto& f : frequency) {
+            symbolValue.push_back(f.first);
+            weights.push_back(f.second);
+        }
+        std::vector<int> lengths = codeLengths(weights);
+        std::vector<int> bySymbol(symbolValue.size());
+        for (size_t i = 0; i < bySymbol.size(); i++) {
+            bySymbol[i] = int(i);
+        }
+        std::stable_sort(bySymbol.begin(), bySymbol.end(), [&](int a, int b) { return lengths[a] > lengths[b]; });
+
+        int minLen = *std::min_element(lengths.begin(), lengths.end());
+        int maxLen = *std::max_element(lengths.begin(), lengths.end());
+        std::vector<uint32_t> countOf(maxLen + 2, 0);
+        std::vector<uint32_t> lowestSym(maxLen + 2, 0);
+        for (int len : lengths) {
+            countOf[len]++;
+        }
+        for (int len = maxLen - 1; len >= 0; len--) {
+            lowestSym[len] = lowestSym[len + 1] + countOf[len + 1];
+        }
+        std::vector<uint64_t> firstCode(maxLen + 1, 0);
+        for (int len = maxLen - 1; len >= minLen; len--) {
+            firstCode[len] = (firstCode[len + 1] + countOf[len + 1]) / 2;
+        }
+        std::map<uint16_t, std::pair<uint64_t, int>> codeOf;
+        for (size_t sym = 0; sym < bySymbol.size(); sym++) {
+            int len = lengths[bySymbol[sym]];
+            codeOf[symbolValue[bySymbol[sym]]] = { firstCode[len] + (sym - lowestSym[len]), len };
+        }
+
+        // Blocks of whole codes, the values of each counted in the block lengths
+        std::vector<uint64_t> blockStart;
+        std::vector<uint8_t> block(size_t(1) << GEN_BLOCK_LOG, 0);
+        int bitPos = 0;
+        uint64_t blockValues = 0;
+        auto flush = [&]() {
+            p.blocks.insert(p.blocks.end(), block.begin(), block.end());
+            putLE16(p.blockLengths, uint32_t(blockValues - 1));
+            std::fill(block.begin(), block.end(), 0);
+            bitPos = 0;
+            blockValues = 0;
+        };
+        std::vector<uint64_t> valuesPerBlock;
+        for (uint16_t v : values) {
+            const auto& code = codeOf[v];
+            if (bitPos + code.second > GEN_BLOCK_PAYLOAD * 8 || blockValues == 65536) {
+                valuesPerBlock.push_back(blockValues);
+                flush();
+            }
+            for (int bit = code.second - 1; bit >= 0; bit--) {
+                if ((code.first >> bit) & 1) {
+                    block[bitPos >> 3] |= uint8_t(0x80 >> (bitPos & 7));
+                }
+                bitPos++;
+            }
+            blockValues++;
+        }
+        valuesPerBlock.push_back(blockValues);
+        flush();
+        uint32_t numBlocks = uint32_t(valuesPerBlock.size());
+        blockStart.assign(numBlocks, 0);
+        for (uint32_t b = 1; b < numBlocks; b++) {
+            blockStart[b] = blockStart[b - 1] + valuesPerBlock[b - 1];
+        }
+        // Padding block, the sparse entries past the last value point into it
+        putLE16(p.blockLengths, 0xFFFF);
+
+        // Block and offset of the middle value of every span
+        uint64_t span = 1ULL << GEN_SPAN_LOG;
+        uint64_t total = values.size();
+        for (uint64_t k = 0; k < (total + span - 1) / span; k++) {
+            uint64_t middle = k * span + span / 2;
+            uint32_t b = numBlocks;
+            uint64_t offset = middle - total;
+            if (middle < total) {
+                b = uint32_t(std::upper_bound(blockStart.begin(), blockStart.end(), middle) - blockStart.begin() - 1);
+                offset = middle - blockStart[b];
+            }
+            putLE32(p.sparseIndex, b);
+            putLE16(p.sparseIndex, uint32_t(offset));
+        }
+
+        p.sizes.push_back(flags);
+        p.sizes.push_back(GEN_BLOCK_LOG);
+        p.sizes.push_back(GEN_SPAN_LOG);
+        p.sizes.push_back(1);
+        putLE32(p.sizes, numBlocks);
+        p.sizes.push_back(uint8_t(maxLen));
+        p.sizes.push_back(uint8_t(minLen));
+        for (int len = minLen; len <= maxLen; len++) {
+            putLE16(p.sizes, lowestSym[len]);
+        }
+        putLE16(p.sizes, uint32_t(bySymbol.size()));
+        for (int original : bySymbol) {
+            // Every symbol a leaf: its value on the left, 0xFFF on the right
+            uint16_t left = symbolValue[original];
+            p.sizes.push_back(uint8_t(left));
+            p.sizes.push_back(uint8_t((left >> 8) | 0xF0));
+            p.sizes.push_back(0xFF);
+        }
+        if (bySymbol.size() & 1) {
+            p.sizes.push_back(0);
+        }
+        return p;
+    }
+
+    // Values of one side to move in one leading pawn file, don't-care indices given the most
+    // common value so they cost next to nothing
+    std::vector<uint16_t> fileValues(const SolvedTable& t, Color stm, int file, bool dtz) {
+        const std::vector<int8_t>& wdl = t.wdl[stm][file];
+        std::vector<uint16_t> values(wdl.size());
+        std::vector<bool> known(wdl.size());
+        std::map<uint16_t, uint64_t> frequency;
+        for (size_t i = 0; i < wdl.size(); i++) {
+            if (wdl[i] == WDL_NONE || (dtz && wdl[i] == WDL_DRAW)) {
+                continue;
+            }
+            if (dtz) {
+                int d = std::abs(t.dtz[stm][file][i]);
+                // Cursed wins and blessed losses are stored in moves
+                values[i] = uint16_t(d > 100 ? (d - 101) / 2 : d - 1);
+            }
+            else {
+                values[i] = uint16_t(wdl[i] + 2);
+            }
+            known[i] = true;
+            frequency[values[i]]++;
+        }
+        uint16_t filler = 0;
+        uint64_t best = 0;
+        for (const auto& f : frequency) {
+            if (f.second > best) {
+                best = f.second;
+                filler = f.first;
+            }
+        }
+        for (size_t i = 0; i < values.size(); i++) {
+            if (!known[i]) {
+                values[i] = filler;
+            }
+        }
+        return values;
+    }
+
+    // WDL files store both sides to move unless the material is symmetric, DTZ files white to move
+    bool writeTable(const SolvedTable& t, const std::string& path, bool dtz) {
+        int sides = !dtz && !t.symmetric ? 2 : 1;
+        bool bothPawns = t.tableMaterial.pawnCount[1] > 0;
+        std::vector<uint8_t> out;
+        putLE32(out, dtz ? TB_DTZ_MAGIC : TB_WDL_MAGIC);
+        out.push_back(uint8_t((t.symmetric ? 0 : TB_SPLIT) | (t.tableMaterial.hasPawns ? TB_HAS_PAWNS : 0)));
+        for (int file = 0; file < t.fileCount; file++) {
+            out.push_back(0x00);
+            if (bothPawns) {
+                out.push_back(0x11);
+            }
+            for (int k = 0; k < t.tableMaterial.pieceCount; k++) {
+                out.push_back(uint8_t(t.pieces[k] | t.pieces[k] << 4));
+            }
+        }
+        if (out.size() & 1) {
+            out.push_back(0);
+        }
+
+        std::vector<PackedValues> packed;
+        for (int file = 0; file < t.fileCount; file++) {
+            for (int side = 0; side < sides; side++) {
+                uint8_t flags = dtz ? uint8_t(TB_WIN_PLIES | TB_LOSS_PLIES) : 0;
+                packed.push_back(pack(fileValues(t, Color(side), file, dtz), flags));
+            }
+        }
+        for (const PackedValues& p : packed) {
+            out.insert(out.end(), p.sizes.begin(), p.sizes.end());
+        }
+        for (const PackedValues& p : packed) {
+            out.insert(out.end(), p.sparseIndex.begin(), p.sparseIndex.end());
+        }
+        for (const PackedValues& p : packed) {
+            out.insert(out.end(), p.blockLengths.begin(), p.blockLengths.end());
+        }
+        for (const PackedValues& p : packed) {
+            out.resize((out.size() + 63) & ~size_t(63), 0);
+            out.insert(out.end(), p.blocks.begin(), p.blocks.end());
+        }
+        while (out.size() % 64 != 16) {
+            out.push_back(0);
+        }
+
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(out.data()), std::streamsize(out.size()));
+        if (!file) {
+            return false;
+        }
+        std::cout << "wrote " << path << ", " << out.size() << " bytes" << std::endl;
+        return true;
+    }
+
+    // ======================
+    // Verification
+    // ======================
+
+    int verify(const std::string& name, const std::vector<Sample>& samples) {
+        Position position;
+        int failures = 0;
+        int mismatches = 0;
+        for (const Sample& sample : samples) {
+            position.setFen(sample.fen);
+            Wdl wdl;
+            int dtz;
+            if (!probeWdl(position, wdl) || !probeDtz(position, dtz)) {
+                failures++;
+                continue;
+            }
+            // Cursed distances lose their parity in the file
+            bool dtzOk = std::abs(sample.dtz) > 100 ? std::abs(dtz - sample.dtz) <= 1 : dtz == sample.dtz;
+            if (wdl != sample.wdl || !dtzOk) {
+                if (mismatches++ < 10) {
+                    std::cout << "  " << sample.fen << ": wdl " << wdl << " dtz " << dtz << ", expected wdl " << sample.wdl << " dtz " << sample.dtz << std::endl;
+                }
+            }
+        }
+        std::cout << "verify " << name << ": " << samples.size() << " positions, " << failures << " failed probes, "
+            << mismatches << " mismatches" << std::endl;
+        return failures + mismatches;
+    }
+
+    void printUsage() {
+        std::cerr << "usage: tbgen DIR NAME... [--verify]" << std::endl
+            << "  NAME is a material of up to " << GEN_MAX_PIECES << " pieces such as KRvK or KPvKP" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string directory;
+    std::vector<Material> materials;
+    bool verifyTables = false;
+    for (int i = 1; i < argc; i++) {
+        Material m;
+        if (!strcmp(argv[i], "--verify")) {
+            verifyTables = true;
+        }
+        else if (directory.empty()) {
+            directory = argv[i];
+        }
+        else if (parseName(argv[i], m)) {
+            materials.push_back(m.canonical());
+        }
+        else {
+            std::cerr << "bad material " << argv[i] << std::endl;
+            printUsage();
+            return 1;
+        }
+    }
+    if (directory.empty() || materials.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    attacks::init();
+    initEncoding();
+
+    if (verifyTables) {
+        for (const Material& m : materials) {
+            verifySamples[m.name()];
+        }
+    }
+    for (const Material& m : materials) {
+        if (!solve(m)) {
+            return 1;
+        }
+    }
+
+    // The endings are written too, the prober needs them for captures and promotions
+    for (const auto& entry : solvedTables) {
+        const SolvedTable& t = *entry.second;
+        if (t.tableMaterial.pieceCount < 3) {
+            continue;
+        }
+        if (!writeTable(t, directory + "/" + entry.first + ".rtbw", false) || !writeTable(t, directory + "/" + entry.first + ".rtbz", true)) {
+            std::cerr << "cannot write " << entry.first << " to " << directory << std::endl;
+            return 1;
+        }
+    }
+
+    if (!verifyTables) {
+        return 0;
+    }
+    tablebase::init(directory);
+    std::cout << "prober found " << getTableCount() << " tables, up to " << getMaxPieces() << " pieces" << std::endl;
+    int errors = 0;
+    for (const auto& entry : verifySamples) {
+        errors += verify(entry.first, entry.second);
+    }
+    return errors ? 1 : 0;
+}
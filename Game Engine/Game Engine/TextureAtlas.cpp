@@ -0,0 +1,99 @@
+#include "TextureAtlas.h"
+#include <algorithm>
+#include "Loaders.h"
+#include "Exceptions.h"
+
+namespace {
+    const char* pieceNames[PIECE_TYPE_NB] = { "pawn", "knight", "bishop", "rook", "queen", "king" };
+}
+
+// Constructor and destructor
+
+TextureAtlas::TextureAtlas(SDL_Renderer* renderer, const std::string& directory) : texture(nullptr) {
+    // Decode every asset exactly once
+    SDL_Surface* sprites[2 * PIECE_TYPE_NB] = {};
+    int cellW = 0;
+    int cellH = 0;
+    try {
+        for (int pc = 0; pc < 2 * PIECE_TYPE_NB; pc++) {
+            std::string path = directory + pieceNames[typeOf(pc)] + (colorOf(pc) == WHITE ? ".png" : "1.png");
+            sprites[pc] = loaders::loadSurface(path);
+            cellW = std::max(cellW, sprites[pc]->w);
+            cellH = std::max(cellH, sprites[pc]->h);
+        }
+    }
+    catch (...) {
+        for (SDL_Surface* sprite : sprites) {
+            SDL_FreeSurface(sprite);
+        }
+        throw;
+    }
+
+    int strideW = cellW + 2 * ATLAS_PADDING;
+    int strideH = cellH + 2 * ATLAS_PADDING;
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, strideW * (PIECE_TYPE_NB + 1), strideH * COLOR_NB, 32, SDL_PIXELFORMAT_RGBA32);
+    if (surface == nullptr) {
+        for (SDL_Surface* sprite : sprites) {
+            SDL_FreeSurface(sprite);
+        }
+        throw UnableToBuildAtlas(directory);
+    }
+
+    // Copy the pixels as they are, alpha included, instead of blending onto the empty atlas
+    for (int pc = 0; pc < 2 * PIECE_TYPE_NB; pc++) {
+        SDL_Rect& cell = cells[pc];
+        cell = { typeOf(pc) * strideW + ATLAS_PADDING, colorOf(pc) * strideH + ATLAS_PADDING, cellW, cellH };
+        SDL_Rect target = cell; // The blit writes the clipped rectangle back
+        SDL_SetSurfaceBlendMode(sprites[pc], SDL_BLENDMODE_NONE);
+        int result = sprites[pc]->w == cellW && sprites[pc]->h == cellH
+            ? SDL_BlitSurface(sprites[pc], nullptr, surface, &target)
+            : SDL_BlitScaled(sprites[pc], nullptr, surface, &target);
+        SDL_FreeSurface(sprites[pc]);
+        sprites[pc] = nullptr;
+        if (result < 0) {
+            for (SDL_Surface* sprite : sprites) {
+                SDL_FreeSurface(sprite);
+            }
+            SDL_FreeSurface(surface);
+            throw UnableToBuildAtlas(directory);
+        }
+    }
+
+    // The white cell is filled to its border, only its inside is sampled so filtering never picks up the gutter
+    SDL_Rect white = { PIECE_TYPE_NB * strideW, 0, strideW, strideH };
+    SDL_FillRect(surface, &white, SDL_MapRGBA(surface->format, 255, 255, 255, 255));
+    solidCell = { white.x + ATLAS_PADDING + 1, white.y + ATLAS_PADDING + 1, cellW - 2, cellH - 2 };
+
+    for (int pc = 0; pc < 2 * PIECE_TYPE_NB; pc++) {
+        masks[pc] = HitMask::fromAlpha(surface, cells[pc]);
+    }
+
+    texture = SDL_CreateTextureFromSurface(renderer, surface);
+    SDL_FreeSurface(surface);
+    if (texture == nullptr) {
+        throw UnableToCreateTextureFromSurface(directory);
+    }
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+}
+
+TextureAtlas::~TextureAtlas() {
+    SDL_DestroyTexture(texture);
+}
+
+// Getters
+
+SDL_Texture* TextureAtlas::getTexture() const {
+    return texture;
+}
+
+const SDL_Rect& TextureAtlas::getCell(PieceCode pc) const {
+    return cells[pc];
+}
+
+const SDL_Rect& TextureAtlas::getSolidCell() const {
+    return solidCell;
+}
+
+const HitMask& TextureAtlas::getMask(PieceCode pc) const {
+    return masks[pc];
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <SDL.h>
+#include <string>
+#include "Bitboard.h"
+#include "HitMask.h"
+
+#define ATLAS_PADDING 1 // Transparent gutter around each sprite so scaled copies never bleed into a neighbour
+
+// All 12 piece sprites decoded once and packed into a single texture, one row per
+// color and one column per piece type, plus an opaque white cell for flat colored
+// quads. Pieces only keep their cell of it, so the whole piece set and the move
+// highlights cost one texture and one bind per frame.
+
+class TextureAtlas {
+    SDL_Texture* texture;
+    SDL_Rect cells[2 * PIECE_TYPE_NB];
+    HitMask masks[2 * PIECE_TYPE_NB]; // Opacity of each sprite at its source resolution, the pixels themselves are not kept
+    SDL_Rect solidCell;
+public:
+    // Loads <directory><piece>.png for white and <directory><piece>1.png for black, throws on failure
+    TextureAtlas(SDL_Renderer* renderer, const std::string& directory);
+    ~TextureAtlas();
+    TextureAtlas(const TextureAtlas&) = delete;
+    TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+    SDL_Texture* getTexture() const;
+    const SDL_Rect& getCell(PieceCode pc) const;
+    // Plain white texels, tinted by the vertex color to draw flat rectangles
+    const SDL_Rect& getSolidCell() const;
+
+    const HitMask& getMask(PieceCode pc) const;
+};
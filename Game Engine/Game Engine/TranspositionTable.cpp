@@ -0,0 +1,152 @@
+#include "TranspositionTable.h"
+#include <new>
+
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#endif
+
+// Packed layout: move (16) | score (16) | eval (16) | depth (8) | bound (2) | generation (6)
+
+namespace {
+    constexpr int GENERATION_BITS = 6;
+    constexpr uint8_t GENERATION_MASK = (1 << GENERATION_BITS) - 1;
+}
+
+uint64_t TranspositionTable::pack(Move move, int score, int eval, int depth, Bound bound, uint8_t generation) {
+    return uint64_t(move.getRaw())
+        | uint64_t(uint16_t(int16_t(score))) << 16
+        | uint64_t(uint16_t(int16_t(eval))) << 32
+        | uint64_t(uint8_t(int8_t(depth))) << 48
+        | uint64_t(bound) << 56
+        | uint64_t(generation & GENERATION_MASK) << 58;
+}
+
+TTData TranspositionTable::unpack(uint64_t data) {
+    TTData out;
+    uint16_t raw = uint16_t(data);
+    out.move = Move(raw & 0x3F, (raw >> 6) & 0x3F, raw >> 12);
+    out.score = int16_t(uint16_t(data >> 16));
+    out.eval = int16_t(uint16_t(data >> 32));
+    out.depth = int8_t(uint8_t(data >> 48));
+    out.bound = Bound((data >> 56) & 3);
+    return out;
+}
+
+// Constructor and destructor
+
+TranspositionTable::TranspositionTable(size_t megabytes) {
+    // A search needs some table, settle for the smallest one and give up without it
+    if (!resize(megabytes) && !resize(1)) {
+        throw std::bad_alloc();
+    }
+}
+
+TranspositionTable::~TranspositionTable() {
+    delete[] buckets;
+}
+
+bool TranspositionTable::resize(size_t megabytes) {
+    size_t target = (megabytes ? megabytes : 1) * 1024 * 1024 / sizeof(Bucket);
+    size_t count = 1;
+    while (count * 2 <= target) {
+        count *= 2;
+    }
+
+    // The old table goes only once the new one exists, a failed resize leaves it usable
+    Bucket* allocated = new (std::nothrow) Bucket[count];
+    if (!allocated) {
+        return false;
+    }
+    delete[] buckets;
+    buckets = allocated;
+    bucketCount = count;
+    clear();
+    return true;
+}
+
+void TranspositionTable::clear() {
+    for (size_t i = 0; i < bucketCount; i++) {
+        for (Entry& e : buckets[i].entries) {
+            e.check.store(0, std::memory_order_relaxed);
+            e.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    generation = 0;
+}
+
+void TranspositionTable::newSearch() {
+    generation = (generation + 1) & GENERATION_MASK;
+}
+
+// Probing and storing
+
+bool TranspositionTable::probe(uint64_t key, TTData& out) const {
+    Bucket& bucket = bucketFor(key);
+    for (Entry& e : bucket.entries) {
+        uint64_t data = e.data.load(std::memory_order_relaxed);
+        uint64_t check = e.check.load(std::memory_order_relaxed);
+        if ((check ^ data) == key && data) {
+            out = unpack(data);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, Move move, int score, int eval, int depth, Bound bound) {
+    Bucket& bucket = bucketFor(key);
+    Entry* replace = &bucket.entries[0];
+    int worst = 1 << 30;
+
+    for (Entry& e : bucket.entries) {
+        uint64_t data = e.data.load(std::memory_order_relaxed);
+        uint64_t check = e.check.load(std::memory_order_relaxed);
+
+        // Same position: overwrite, but keep the old best move if we have none
+        if ((check ^ data) == key || !data) {
+            if (move.isNull() && data) {
+                move = unpack(data).move;
+            }
+            replace = &e;
+            break;
+        }
+
+        // Otherwise evict the shallowest entry, entries from older searches count as shallower
+        int age = (generation - int(data >> 58)) & GENERATION_MASK;
+        int value = unpack(data).depth - 8 * age;
+        if (value < worst) {
+            worst = value;
+            replace = &e;
+        }
+    }
+
+    uint64_t data = pack(move, score, eval, depth, bound, generation);
+    replace->data.store(data, std::memory_order_relaxed);
+    replace->check.store(key ^ data, std::memory_order_relaxed);
+}
+
+void TranspositionTable::prefetch(uint64_t key) const {
+#if defined(_MSC_VER)
+    _mm_prefetch(reinterpret_cast<const char*>(&bucketFor(key)), _MM_HINT_T0);
+#else
+    __builtin_prefetch(&bucketFor(key));
+#endif
+}
+
+// Stats
+
+int TranspositionTable::hashfull() const {
+    int used = 0;
+    size_t samples = bucketCount < 1000 ? bucketCount : 1000;
+    for (size_t i = 0; i < samples; i++) {
+        for (Entry& e : buckets[i].entries) {
+            uint64_t data = e.data.load(std::memory_order_relaxed);
+            used += data && int(data >> 58) == generation;
+        }
+    }
+    return int(used * 1000 / (samples * TT_BUCKET_SIZE));
+}
+
+size_t TranspositionTable::getSizeMB() const {
+    return bucketCount * sizeof(Bucket) / (1024 * 1024);
+}
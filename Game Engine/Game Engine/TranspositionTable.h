@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "Move.h"
+
+#define DEFAULT_HASH_MB 16
+#define TT_BUCKET_SIZE 4
+
+enum Bound : uint8_t {
+    BOUND_NONE,
+    BOUND_UPPER,
+    BOUND_LOWER,
+    BOUND_EXACT = BOUND_UPPER | BOUND_LOWER
+};
+
+// Unpacked view of one table entry
+struct TTData {
+    Move move;
+    int score;
+    int eval;
+    int depth;
+    Bound bound;
+};
+
+// Shared transposition table. Each entry is two 64 bit words, the packed data and
+// key ^ data. A reader accepts an entry only if the XOR gives its key back, so an
+// entry torn by two threads writing at once reads as a miss and no locks are needed.
+// Four entries make one 64 byte bucket, aligned to a cache line.
+
+class TranspositionTable {
+    struct Entry {
+        std::atomic<uint64_t> check;
+        std::atomic<uint64_t> data;
+    };
+
+    struct alignas(64) Bucket {
+        Entry entries[TT_BUCKET_SIZE];
+    };
+
+    Bucket* buckets = nullptr;
+    size_t bucketCount = 0;
+    uint8_t generation = 0;
+
+    Bucket& bucketFor(uint64_t key) const { return buckets[key & (bucketCount - 1)]; }
+
+    static uint64_t pack(Move move, int score, int eval, int depth, Bound bound, uint8_t generation);
+    static TTData unpack(uint64_t data);
+public:
+    TranspositionTable(size_t megabytes = DEFAULT_HASH_MB);
+    ~TranspositionTable();
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    // Reallocates to the largest power of two bucket count fitting in the given size, false
+    // and the old table kept when the memory is not there
+    bool resize(size_t megabytes);
+    void clear();
+
+    // Ages the table, entries of older searches get replaced first
+    void newSearch();
+
+    bool probe(uint64_t key, TTData& out) const;
+    void store(uint64_t key, Move move, int score, int eval, int depth, Bound bound);
+
+    // Hints the CPU to fetch the bucket ahead of a probe
+    void prefetch(uint64_t key) const;
+
+    // Permille of sampled entries written by the current search, as reported by UCI
+    int hashfull() const;
+    size_t getSizeMB() const;
+};
@@ -0,0 +1,282 @@
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "Attacks.h"
+#include "EngineWorker.h"
+#include "MoveGen.h"
+#include "Tablebase.h"
+
+// Headless UCI front end on the same engine worker as the SDL game
+//   uci    reads UCI commands from stdin and answers on stdout
+// Commands are parsed on the main thread and only ever hand work over to the worker, so no
+// command waits for a search. Engine output is printed by a second thread that the worker
+// wakes up whenever it queues an event, nothing polls.
+
+#define UCI_ENGINE_NAME "Game Engine"
+#define UCI_ENGINE_AUTHOR "the Game Engine developers"
+#define UCI_MAX_HASH_MB 65536
+
+namespace {
+    std::mutex outputMutex;
+
+    void send(const std::string& line) {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::cout << line << std::endl;
+    }
+
+    std::string formatScore(int score) {
+        if (std::abs(score) >= MATE_BOUND) {
+            int moves = (MATE_SCORE - std::abs(score) + 1) / 2;
+            return "mate " + std::to_string(score > 0 ? moves : -moves);
+        }
+        return "cp " + std::to_string(score);
+    }
+
+    std::string formatEvent(const EngineEvent& event) {
+        std::ostringstream ss;
+        if (event.type == EngineEvent::BEST_MOVE) {
+            ss << "bestmove " << event.bestMove.toString();
+            if (!event.ponderMove.isNull()) {
+                ss << " ponder " << event.ponderMove.toString();
+            }
+            return ss.str();
+        }
+        ss << "info depth " << event.depth << " seldepth " << event.selDepth << " score " << formatScore(event.score)
+            << " nodes " << event.nodes << " nps " << event.nodes * 1000 / uint64_t(std::max<int64_t>(event.timeMs, 1))
+            << " tbhits " << event.tbHits << " time " << event.timeMs << " pv";
+        for (int i = 0; i < event.pvLength; i++) {
+            ss << ' ' << event.pv[i].toString();
+        }
+        return ss.str();
+    }
+
+    // Wake-up signal between the worker and the printing thread. It has to outlive the
+    // worker, whose destructor may still queue a last best move.
+    struct EventSignal {
+        std::mutex mutex;
+        std::condition_variable wakeUp;
+        bool pending = false;
+        bool quitting = false;
+
+        void notify() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                pending = true;
+            }
+            wakeUp.notify_one();
+        }
+    };
+
+    void printEvents(EngineWorker& engine, EventSignal& signal) {
+        EngineEvent event;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(signal.mutex);
+                signal.wakeUp.wait(lock, [&signal] { return signal.pending || signal.quitting; });
+                if (signal.quitting) {
+                    return;
+                }
+                signal.pending = false;
+            }
+            while (engine.poll(event)) {
+                send(formatEvent(event));
+            }
+        }
+    }
+
+    // Protocol state and command handlers
+    class UciSession {
+        EngineWorker& engine;
+        Position position;
+
+        void printOptions() {
+            send("id name " UCI_ENGINE_NAME);
+            send("id author " UCI_ENGINE_AUTHOR);
+            send("option name Hash type spin default " + std::to_string(DEFAULT_HASH_MB) + " min 1 max " + std::to_string(UCI_MAX_HASH_MB));
+            send("option name Threads type spin default 1 min 1 max " + std::to_string(MAX_THREADS));
+            send("option name Ponder type check default false");
+            send("option name Clear Hash type button");
+            send("option name EvalFile type string default <empty>");
+            send("option name Use NNUE type check default true");
+            send("option name OwnBook type check default true");
+            send("option name BookFile type string default <empty>");
+            send("option name SyzygyPath type string default <empty>");
+            send("uciok");
+        }
+
+        void setOption(std::istringstream& ss) {
+            std::string token, name, value;
+            ss >> token;
+            while (ss >> token && token != "value") {
+                name += (name.empty() ? "" : " ") + token;
+            }
+            while (ss >> token) {
+                value += (value.empty() ? "" : " ") + token;
+            }
+            // Option names are case insensitive
+            std::transform(name.begin(), name.end(), name.begin(), [](unsigned char ch) { return char(std::tolower(ch)); });
+
+            // Settings wait for the search to end, only a ponder or infinite search rejects them
+            bool applied = true;
+            if (name == "hash") {
+                int megabytes = std::clamp(std::atoi(value.c_str()), 1, UCI_MAX_HASH_MB);
+                bool allocated;
+                applied = engine.setHash(size_t(megabytes), allocated);
+                if (!allocated) {
+                    send("info string Unable to set the hash to " + std::to_string(megabytes) + " MB, the previous table is kept");
+                }
+            }
+            else if (name == "threads") {
+                applied = engine.setThreads(std::clamp(std::atoi(value.c_str()), 1, MAX_THREADS));
+            }
+            else if (name == "clear hash") {
+                applied = engine.clear();
+            }
+            else if (name == "evalfile") {
+                if (value != "<empty>" && !engine.setEvalFile(value)) {
+                    send("info string Unable to load network " + value);
+                }
+            }
+            else if (name == "use nnue") {
+                applied = engine.setUseNnue(value == "true");
+            }
+            else if (name == "ownbook") {
+                applied = engine.setUseBook(value == "true");
+            }
+            else if (name == "bookfile") {
+                if (!engine.setBookFile(value == "<empty>" ? "" : value)) {
+                    send("info string Unable to open book " + value);
+                }
+            }
+            else if (name == "syzygypath") {
+                if (!engine.setSyzygyPath(value == "<empty>" ? "" : value)) {
+                    send("info string Unable to set the tablebase path while searching");
+                }
+                else if (tablebase::getTableCount()) {
+                    send("info string Found " + std::to_string(tablebase::getTableCount()) + " tablebases, up to "
+                        + std::to_string(tablebase::getMaxPieces()) + " pieces");
+                }
+            }
+            else if (name != "ponder") {
+                send("info string Unknown option " + name);
+            }
+            if (!applied) {
+                send("info string Unable to set " + name + " while searching");
+            }
+        }
+
+        void setPosition(std::istringstream& ss) {
+            std::string token, fen;
+            ss >> token;
+            if (token == "startpos") {
+                fen = START_FEN;
+                ss >> token;
+            }
+            else if (token == "fen") {
+                while (ss >> token && token != "moves") {
+                    fen += token + " ";
+                }
+            }
+            else {
+                return;
+            }
+
+            if (!position.setFen(fen)) {
+                send("info string Invalid FEN " + fen);
+                position.setFen(START_FEN);
+                return;
+            }
+            while (ss >> token) {
+                Move move = parseUciMove(position, token);
+                if (move.isNull()) {
+                    send("info string Illegal move " + token);
+                    return;
+                }
+                position.makeMove(move);
+            }
+        }
+
+        void go(std::istringstream& ss) {
+            SearchLimits limits;
+            bool ponder = false;
+            std::string token;
+            while (ss >> token) {
+                if (token == "wtime") ss >> limits.time[WHITE];
+                else if (token == "btime") ss >> limits.time[BLACK];
+                else if (token == "winc") ss >> limits.increment[WHITE];
+                else if (token == "binc") ss >> limits.increment[BLACK];
+                else if (token == "movestogo") ss >> limits.movesToGo;
+                else if (token == "depth") ss >> limits.depth;
+                else if (token == "nodes") ss >> limits.nodes;
+                else if (token == "movetime") ss >> limits.movetime;
+                else if (token == "infinite") limits.infinite = true;
+                else if (token == "ponder") ponder = true;
+            }
+            limits.depth = std::clamp(limits.depth, 1, MAX_PLY - 1);
+
+            if (ponder) {
+                engine.ponder(position, limits);
+            }
+            else {
+                engine.start(position, limits);
+            }
+        }
+    public:
+        UciSession(EngineWorker& engine) : engine(engine) {
+            position.setFen(START_FEN);
+        }
+
+        // Returns false on quit
+        bool handle(const std::string& line) {
+            std::istringstream ss(line);
+            std::string command;
+            ss >> command;
+
+            if (command == "uci") printOptions();
+            // Answered at once, even while searching. Settings wait for the search themselves.
+            else if (command == "isready") send("readyok");
+            else if (command == "setoption") setOption(ss);
+            else if (command == "ucinewgame") {
+                if (!engine.clear()) {
+                    send("info string Unable to clear the hash while searching");
+                }
+            }
+            else if (command == "position") setPosition(ss);
+            else if (command == "go") go(ss);
+            else if (command == "stop") engine.stop();
+            else if (command == "ponderhit") engine.ponderHit();
+            else if (command == "quit") return false;
+            else if (!command.empty()) send("info string Unknown command " + command);
+            return true;
+        }
+    };
+}
+
+int main() {
+    attacks::init();
+
+    EventSignal signal;
+    EngineWorker engine(DEFAULT_HASH_MB, 1);
+    engine.setEventCallback([&signal] { signal.notify(); });
+    std::thread printer(printEvents, std::ref(engine), std::ref(signal));
+
+    UciSession session(engine);
+    std::string line;
+    while (std::getline(std::cin, line) && session.handle(line)) {
+    }
+
+    engine.stop();
+    {
+        std::lock_guard<std::mutex> lock(signal.mutex);
+        signal.quitting = true;
+    }
+    signal.wakeUp.notify_one();
+    printer.join();
+    return 0;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "Bitboard.h"
+
+// ======================
+// Zobrist keys, generated at compile time from a fixed seed
+// ======================
+
+namespace zobrist {
+
+    // splitmix64 step, good enough spread for hashing keys
+    constexpr uint64_t splitmix(uint64_t& state) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    struct Keys {
+        uint64_t pieceSquare[12][64];
+        uint64_t castling[16];
+        uint64_t enPassant[8];
+        uint64_t side;
+    };
+
+    constexpr Keys makeKeys() {
+        Keys keys{};
+        uint64_t state = 1070372;
+        for (int pc = 0; pc < 12; pc++) {
+            for (int sq = 0; sq < 64; sq++) {
+                keys.pieceSquare[pc][sq] = splitmix(state);
+            }
+        }
+        for (int i = 0; i < 16; i++) {
+            keys.castling[i] = splitmix(state);
+        }
+        for (int f = 0; f < 8; f++) {
+            keys.enPassant[f] = splitmix(state);
+        }
+        keys.side = splitmix(state);
+        return keys;
+    }
+
+    inline constexpr Keys KEYS = makeKeys();
+
+    inline uint64_t pieceSquare(PieceCode pc, int sq) {
+        return KEYS.pieceSquare[pc][sq];
+    }
+
+    inline uint64_t castling(int rights) {
+        return KEYS.castling[rights];
+    }
+
+    inline uint64_t enPassant(int sq) {
+        return KEYS.enPassant[fileOf(sq)];
+    }
+
+    inline uint64_t side() {
+        return KEYS.side;
+    }
+}
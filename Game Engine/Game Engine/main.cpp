@@ -3,15 +3,29 @@
 #include <cmath>
 #include <iostream>
 #include <tuple>
+#include <thread>
+#include <algorithm>
+#include <string>
 #include "Helpers.h"
 #include "PieceManager.h"
 #include "Board.h"
+#include "EngineWorker.h"
+#include "Tablebase.h"
+#include "Profiler.h"
+#include "ProfilerOverlay.h"
 
 #define SCREEN_WIDTH 1600
 #define SCREEN_HEIGHT 800
 #define BOARD_SIZE 100
 #define BOARD_START_X 0
 #define BOARD_START_Y 0
+#define ENGINE_MOVETIME 1000
+#define IDLE_WAIT_MS 500 // Longest the loop sleeps in SDL_WaitEventTimeout when nothing happens
+#define ENGINE_POLL_MS 15 // Same while the engine thinks, so its results show up promptly
+#define OVERLAY_FRAME_MS 16 // Frames are drawn continuously while the profiler overlay is up
+#define TRACE_FILE "trace.json"
+#define BOOK_FILE "book.bin" // Polyglot book used when present, a second argument names another one
+#define SYZYGY_PATH "syzygy" // Tablebase directory used when present, a third argument names others
 
 int responsive_delay(Uint32 miliseconds, SDL_Renderer* renderer, SDL_Window* window) {
     Uint32 startTime = SDL_GetTicks();
@@ -54,41 +68,151 @@ int main(int argc, char* argv[]) {
     Piece::board_ysp = BOARD_START_Y;
     Piece::board_size = BOARD_SIZE;
 
+    // Every sprite comes from one atlas texture, decoded once here
+    try {
+        Piece::atlas = new TextureAtlas(renderer, PIECE_ASSET_DIR);
+    }
+    catch (const std::exception& e) {
+        std::cout << e.what() << std::endl;
+        helpers::quit();
+        return 1;
+    }
+
     // ===============================================
     // Application
     // ===============================================
 
-    // Event loop to keep the window open
-    bool isRunning = true;
-    SDL_Event event;
-    Board b(BOARD_SIZE, BOARD_START_X, BOARD_START_Y);
+    // Scoped so the board and its textures go away before the renderer
+    {
+        // Event loop to keep the window open
+        bool isRunning = true;
+        SDL_Event event;
+        Board b(BOARD_SIZE, BOARD_START_X, BOARD_START_Y);
+        // An optional FEN argument replaces the initial position
+        if (argc > 1 && !b.setPosition(argv[1])) {
+            std::cout << "Invalid FEN " << argv[1] << ", starting from the initial position" << std::endl;
+        }
+        Uint32 lastDrawCalls = 0;
+#if defined(ENABLE_PROFILER)
+        // F3 shows the frame statistics, F4 writes the recorded scopes as a Chrome trace
+        ProfilerOverlay overlay(8 * BOARD_SIZE + 10, 10);
+#endif
+
+        // Engine, space bar plays a move for the side to move. It searches on its own
+        // thread, results are picked up once per frame so the window never freezes.
+        EngineWorker engine(DEFAULT_HASH_MB, std::max(1u, std::thread::hardware_concurrency()));
+        SearchLimits limits;
+        limits.movetime = ENGINE_MOVETIME;
+        std::string bookFile = argc > 2 ? argv[2] : BOOK_FILE;
+        if (engine.setBookFile(bookFile)) {
+            std::cout << "Opening book " << bookFile << " loaded" << std::endl;
+        }
+        else if (argc > 2) {
+            std::cout << "Unable to open book " << bookFile << std::endl;
+        }
+        engine.setSyzygyPath(argc > 3 ? argv[3] : SYZYGY_PATH);
+        if (tablebase::getTableCount()) {
+            std::cout << tablebase::getTableCount() << " tablebases found, up to " << tablebase::getMaxPieces() << " pieces" << std::endl;
+        }
+
+        // Frames are drawn on demand: the loop sleeps in SDL until an event arrives or the
+        // timeout expires, and only redraws when the board or the window says so
+        while (isRunning) {
+
+            int timeout = engine.isSearching() ? ENGINE_POLL_MS : IDLE_WAIT_MS;
+#if defined(ENABLE_PROFILER)
+            if (overlay.isVisible()) {
+                timeout = OVERLAY_FRAME_MS;
+                b.markDirty();
+            }
+#endif
+            bool hasEvent = SDL_WaitEventTimeout(&event, timeout);
+            PROFILE_BEGIN_FRAME();
+            {
+                PROFILE_SCOPE("events");
+                while (hasEvent) {
+                    if (event.type == SDL_QUIT) {
+                        isRunning = false;
+                    }
+                    if (event.type == SDL_WINDOWEVENT) {
+                        b.markDirty(); // Exposed, resized, restored... the old frame may be gone
+                    }
+                    if (event.type == SDL_MOUSEBUTTONDOWN) {
+                        int x, y;
+                        SDL_GetMouseState(&x, &y);
+
+                        if (event.button.button == SDL_BUTTON_LEFT) {
+                            b.mouseDown(x, y);
+                        }
+                    }
+                    if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_SPACE && !engine.isSearching()) {
+                        engine.start(b.getPosition(), limits);
+                    }
+#if defined(ENABLE_PROFILER)
+                    if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F3) {
+                        overlay.toggle();
+                        b.markDirty();
+                    }
+                    if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F4) {
+                        std::cout << (profiler::exportChromeTrace(TRACE_FILE) ? "Trace written to " : "Unable to write ") << TRACE_FILE << std::endl;
+                    }
+#endif
+                    hasEvent = SDL_PollEvent(&event);
+                }
+            }
 
-    while (isRunning) {
+            {
+                PROFILE_SCOPE("engine events");
+                EngineEvent engineEvent;
+                while (engine.poll(engineEvent)) {
+                    if (engineEvent.type == EngineEvent::INFO) {
+                        std::cout << "depth " << engineEvent.depth << " score " << engineEvent.score << " nodes " << engineEvent.nodes << " pv";
+                        for (int i = 0; i < engineEvent.pvLength; i++) {
+                            std::cout << " " << engineEvent.pv[i].toString();
+                        }
+                        std::cout << std::endl;
+                    }
+                    else {
+                        if (engineEvent.fromBook) {
+                            std::cout << "book " << engineEvent.bestMove.toString() << std::endl;
+                        }
+                        b.applyEngineMove(engineEvent.bestMove, engineEvent.positionKey);
+                    }
+                }
+            }
 
-        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255); // Set the draw color to white for clearing
-        SDL_RenderClear(renderer);
+            if (!b.isDirty()) {
+                continue;
+            }
 
-        b.render_board(renderer, {255,204,114,255}, {70,47,8,255});
-        b.render_pieces();
+            helpers::resetDrawCalls();
+            SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255); // Set the draw color to white for clearing
+            SDL_RenderClear(renderer);
+            helpers::countDrawCall();
 
+            b.render_board(renderer, {255,204,114,255}, {70,47,8,255});
+            b.render_pieces();
+#if defined(ENABLE_PROFILER)
+            overlay.render(renderer, *Piece::atlas);
+#endif
 
-        while (SDL_PollEvent(&event)) {
-            if (event.type == SDL_QUIT) {
-                isRunning = false;
+            {
+                PROFILE_SCOPE("present");
+                SDL_RenderPresent(renderer);
             }
-            if (event.type == SDL_MOUSEBUTTONDOWN) {
-                int x, y;
-                SDL_GetMouseState(&x, &y);
+            b.clearDirty();
+            PROFILE_END_FRAME(helpers::getDrawCalls());
 
-                if (event.button.button == SDL_BUTTON_LEFT) {
-                    b.mouseDown(x, y);
-                }
+            if (helpers::getDrawCalls() != lastDrawCalls) {
+                lastDrawCalls = helpers::getDrawCalls();
+                SDL_SetWindowTitle(window, ("SDL Window - " + std::to_string(lastDrawCalls) + " draw calls per frame").c_str());
             }
         }
-
-        SDL_RenderPresent(renderer);
     }
 
+    delete Piece::atlas;
+    Piece::atlas = nullptr;
+
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     SDL_Quit();